@@ -7,73 +7,164 @@
  *
  */
 
-#include <stdio.h>
 #include <string.h>
 #include "basic_io.h"
+#include "../yfmt/yfmt.h"
+#include "../../src/yos/yos.h"
+#include "../../src/yos/ymutex.h"
+#if (BASIC_IO_RETARGET_STDIO == 1)
+#include <stdio.h>
+#include <errno.h>
+#endif
+
 
+static struct basic_io_port *volatile _console = NULL;
+
+#if (BASIC_IO_CONSOLE_LINE_BUFFER == 1)
+struct _basic_io_line {
+	char buf[BASIC_IO_LINE_BUFFER_SIZE];
+	uint16_t len;
+};
+
+/*
+ * Line buffer of each task, only used by the task itself
+ *
+ * タスクごとの行バッファ、そのタスク自身のみ使います
+ */
+static struct _basic_io_line _lines[YOS_MAX_TASK_COUNT];
 
-static struct basic_io_port_operations *volatile _bipo = NULL;
+/*
+ * Held only while a line buffer is written out
+ *
+ * 行バッファを書き出している間のみ保持します
+ */
+static struct ymutex _console_lock;
+#endif
 
-int basic_io_init(struct basic_io_port_operations *ops)
+/*
+ * Return the port to use, i.e. the console for NULL,
+ * or NULL if it is not usable
+ *
+ * 使うポート、つまりNULLの場合コンソールを戻ります
+ * 使えない場合NULLを戻ります
+ */
+static struct basic_io_port *_basic_io_port(struct basic_io_port *port)
 {
-	if (ops == NULL) {
+	if (port == NULL) {
+		port = _console;
+	}
+
+	if (port == NULL || port->ops == NULL) {
+		return NULL;
+	}
+
+	return port;
+}
+
+int basic_io_init(struct basic_io_port *port, struct basic_io_port_operations *ops, void *ctx)
+{
+	if (port == NULL || ops == NULL) {
 		return -1;
 	}
-	_bipo = ops;
+	port->ops = ops;
+	port->ctx = ctx;
 
-	if (_bipo->basic_io_port_init != NULL) {
-		return _bipo->basic_io_port_init();
+	if (ops->basic_io_port_init != NULL) {
+		return ops->basic_io_port_init(ctx);
 	} else {
 		return 0;
 	}
 }
 
-int basic_io_deinit(void)
+int basic_io_deinit(struct basic_io_port *port)
 {
 	int ret = -1;
-	if (_bipo == NULL) {
+	port = _basic_io_port(port);
+	if (port == NULL) {
 		return ret;
 	}
 
-	if (_bipo->basic_io_port_deinit != NULL) {
-		ret = _bipo->basic_io_port_deinit();
+	if (port->ops->basic_io_port_deinit != NULL) {
+		ret = port->ops->basic_io_port_deinit(port->ctx);
 	} else {
 		ret = 0;
 	}
-	_bipo = NULL;
+	if (_console == port) {
+		_console = NULL;
+	}
+	port->ops = NULL;
 
 	return ret;
 }
 
-int basic_io_has_data_to_read(void)
+void basic_io_set_console(struct basic_io_port *port)
+{
+#if (BASIC_IO_CONSOLE_LINE_BUFFER == 1)
+	ymutex_init(&_console_lock);
+#endif
+#if (BASIC_IO_RETARGET_STDIO == 1)
+	/*
+	 * Lines are buffered by basic_io per task, not by newlib
+	 *
+	 * 行のバッファリングはnewlibではなく、basic_ioがタスクごとに行います
+	 */
+	setvbuf(stdout, NULL, _IONBF, 0);
+	setvbuf(stderr, NULL, _IONBF, 0);
+#endif
+	_console = port;
+}
+
+struct basic_io_port *basic_io_get_console(void)
+{
+	return _console;
+}
+
+int basic_io_has_data_to_read(struct basic_io_port *port)
 {
-	if (_bipo == NULL || _bipo->basic_io_port_can_read == NULL) {
+	port = _basic_io_port(port);
+	if (port == NULL || port->ops->basic_io_port_can_read == NULL) {
 		return 0;
 	}
 
-	return _bipo->basic_io_port_can_read();
+	return port->ops->basic_io_port_can_read(port->ctx);
 }
 
-int basic_io_read_byte(uint8_t *byte_read)
+int basic_io_read_byte(struct basic_io_port *port, uint8_t *byte_read)
 {
-	if (_bipo == NULL || _bipo->basic_io_port_read_byte_no_block == NULL) {
+	port = _basic_io_port(port);
+	if (port == NULL || port->ops->basic_io_port_read_byte_no_block == NULL) {
 		return -1;
 	}
 
-	return (_bipo->basic_io_port_read_byte_no_block(byte_read));
+	/*
+	 * What is written before reading(e.g. a prompt) should be seen first
+	 *
+	 * 読み込む前に書き込んだもの（例：プロンプト）が先に見えるようにします
+	 */
+	basic_io_flush(port);
+
+	return (port->ops->basic_io_port_read_byte_no_block(port->ctx, byte_read));
 }
 
-int32_t basic_io_read(char *buf, uint16_t buf_len)
+/*
+ * Read what is there now, by the block operation if the port has it
+ *
+ * 今あるデータを読み込みます、ポートにブロック操作があればそれを使います
+ */
+static int32_t _basic_io_read_no_block(struct basic_io_port *port, char *buf, uint16_t buf_len,
+										int stop_at_text_end)
 {
-	if (buf == NULL) {
-		return -1;
+	if (port->ops->basic_io_port_read_no_block != NULL) {
+		return port->ops->basic_io_port_read_no_block(port->ctx, (uint8_t *)buf, buf_len, stop_at_text_end);
 	}
 
 	uint16_t cnt = 0;
 	while (cnt < buf_len) {
-		if (basic_io_read_byte(buf + cnt) == 0) {
-			cnt++;
-		} else {
+		if (basic_io_read_byte(port, (uint8_t *)(buf + cnt)) != 0) {
+			break;
+		}
+		cnt++;
+		if (stop_at_text_end && buf[cnt - 1] == BASIC_IO_TEXT_END_MARK) {
 			break;
 		}
 	}
@@ -81,26 +172,126 @@ int32_t basic_io_read(char *buf, uint16_t buf_len)
 	return cnt;
 }
 
-int32_t basic_io_readline(char *buf, uint16_t buf_len)
+/*
+ * Write what can be written now, by the block operation if the port has it
+ *
+ * 今書き込める分を書き込みます、ポートにブロック操作があればそれを使います
+ */
+static int32_t _basic_io_write_no_block(struct basic_io_port *port, const char *data, uint16_t data_len)
 {
-	if (buf == NULL) {
+	if (port->ops->basic_io_port_write_no_block != NULL) {
+		return port->ops->basic_io_port_write_no_block(port->ctx, (const uint8_t *)data, data_len);
+	}
+
+	uint16_t cnt = 0;
+	while (cnt < data_len) {
+		if (port->ops->basic_io_port_write_byte_no_block(port->ctx, *(data + cnt)) != 0) {
+			break;
+		}
+		cnt++;
+	}
+
+	return cnt;
+}
+
+int32_t basic_io_read(struct basic_io_port *port, char *buf, uint16_t buf_len)
+{
+	port = _basic_io_port(port);
+	if (port == NULL || buf == NULL) {
+		return -1;
+	}
+
+	basic_io_flush(port);
+
+	return _basic_io_read_no_block(port, buf, buf_len, 0);
+}
+
+int32_t basic_io_read_timeout(struct basic_io_port *port, char *buf, uint16_t buf_len, uint16_t timeout_ms)
+{
+	port = _basic_io_port(port);
+	if (port == NULL || buf == NULL || buf_len == 0) {
 		return -1;
 	}
 
+	basic_io_flush(port);
+
+	int32_t cnt;
+	int result;
+	while (1) {
+		cnt = _basic_io_read_no_block(port, buf, buf_len, 0);
+		if (cnt != 0) {
+			return cnt;
+		}
+
+		if (port->ops->basic_io_port_wait_readable != NULL) {
+			/*
+			 * Sleep until any byte comes
+			 *
+			 * 何かのバイトが来るまで寝ます
+			 */
+			result = port->ops->basic_io_port_wait_readable(port->ctx, BASIC_IO_WAIT_ANY_BYTE, timeout_ms);
+			if (result != 0) {
+				return (result == BASIC_IO_RET_TIMEOUT) ? BASIC_IO_RET_TIMEOUT : -1;
+			}
+		} else {
+			/* No data yet and the port cannot wait, retry */
+#if (YOS_PREEMPTION == 0)
+			/* Let other tasks run while waiting for data */
+			schedule();
+#endif
+		}
+	}
+}
+
+int32_t basic_io_readline(struct basic_io_port *port, char *buf, uint16_t buf_len)
+{
+	return basic_io_readline_timeout(port, buf, buf_len, BASIC_IO_WAIT_FOREVER);
+}
+
+int32_t basic_io_readline_timeout(struct basic_io_port *port, char *buf, uint16_t buf_len, uint16_t timeout_ms)
+{
+	port = _basic_io_port(port);
+	if (port == NULL || buf == NULL || buf_len == 0) {
+		return -1;
+	}
+
+	basic_io_flush(port);
+
 	uint16_t _byte_read = 0;
-	char byte;
+	int32_t cnt;
 	int result = -1;
 	while (_byte_read < buf_len) {
-		result = basic_io_read_byte(buf + _byte_read);
-		if (result == 0) {
-			byte = *(buf + _byte_read);
-			_byte_read++;
-			if (byte == BASIC_IO_TEXT_END_MARK) {
+		cnt = _basic_io_read_no_block(port, buf + _byte_read, buf_len - _byte_read, 1);
+		if (cnt < 0) {
+			/* Error occurs */
+			*(buf + _byte_read) = '\0';
+			return cnt;
+		} else if (cnt > 0) {
+			_byte_read += cnt;
+			if (*(buf + _byte_read - 1) == BASIC_IO_TEXT_END_MARK) {
 				*(buf + _byte_read - 1) = '\0';
 				break;
 			}
+		} else if (port->ops->basic_io_port_wait_readable != NULL) {
+			/*
+			 * Sleep until a whole line is there, so the caller does not
+			 * use any CPU while the input is idle.
+			 *
+			 * 一行全部が揃うまで寝ます、入力がない間に呼び出し元はCPUを使いません
+			 */
+			result = port->ops->basic_io_port_wait_readable(port->ctx, BASIC_IO_WAIT_TEXT_END, timeout_ms);
+			if (result == BASIC_IO_RET_TIMEOUT && _byte_read == 0) {
+				return BASIC_IO_RET_TIMEOUT;
+			} else if (result != 0) {
+				*(buf + _byte_read) = '\0';
+				return _byte_read;
+			}
 		} else {
-			/* Error occurs */
+			/* No data yet and the port cannot wait, retry */
+#if (YOS_PREEMPTION == 0)
+			/* Let other tasks run while waiting for data */
+			schedule();
+#endif
 			continue;
 		}
 	}
@@ -112,35 +303,262 @@ int32_t basic_io_readline(char *buf, uint16_t buf_len)
 	return _byte_read;
 }
 
-int32_t basic_io_write(char *data, uint16_t data_len, int block)
+/*
+ * Write to the port as it is, without the line buffer
+ *
+ * 行バッファを使わずに、そのままポートへ書き込みます
+ */
+static int32_t _basic_io_write(struct basic_io_port *port, const char *data, uint16_t data_len, int block)
 {
-	if (_bipo == NULL || _bipo->basic_io_port_write_byte_no_block == NULL || data == NULL) {
-		return -1;
-	}
-
 	uint16_t byte_written = 0;
+	int32_t cnt;
 	while (byte_written < data_len) {
-		if (_bipo->basic_io_port_write_byte_no_block(*(data + byte_written)) == 0) {
-			byte_written++;
-		} else {
-			/* error */
+		cnt = _basic_io_write_no_block(port, data + byte_written, data_len - byte_written);
+		if (cnt < 0) {
+			break;
+		}
+		byte_written += cnt;
+		if (byte_written < data_len) {
+			/* Cannot write more now */
 			if (!block) {
 				break;
 			}
+			if (port->ops->basic_io_port_wait_writable != NULL
+				&& port->ops->basic_io_port_wait_writable(port->ctx) != 0) {
+				break;
+			}
+		}
+	}
+
+	return byte_written;
+}
+
+#if (BASIC_IO_CONSOLE_LINE_BUFFER == 1)
+/*
+ * Line buffer of the calling task if writes to the port are buffered
+ * (console, yos started, not in ISR), or NULL
+ *
+ * ポートへの書き込みがバッファリングされる場合（コンソール、yos開始済み、ISRでない）
+ * 呼び出したタスクの行バッファを、その他はNULLを戻ります
+ */
+static struct _basic_io_line *_basic_io_line(struct basic_io_port *port)
+{
+	if (port != _console || !yos_is_started() || yos_in_isr()) {
+		return NULL;
+	}
+
+	return _lines + yos_get_current_task_id();
+}
+
+static int32_t _basic_io_line_flush(struct basic_io_port *port, struct _basic_io_line *line)
+{
+	int32_t ret;
+	if (line->len == 0) {
+		return 0;
+	}
+
+	ymutex_lock(&_console_lock);
+	ret = _basic_io_write(port, line->buf, line->len, 1);
+	ymutex_unlock(&_console_lock);
+	line->len = 0;
+
+	return ret;
+}
+
+static int32_t _basic_io_line_write(struct basic_io_port *port, struct _basic_io_line *line,
+									const char *data, uint16_t data_len)
+{
+	uint16_t byte_written = 0;
+	uint16_t n;
+	const char *newline;
+	while (byte_written < data_len) {
+		n = data_len - byte_written;
+		if (n > BASIC_IO_LINE_BUFFER_SIZE - line->len) {
+			n = BASIC_IO_LINE_BUFFER_SIZE - line->len;
+		}
+		newline = memchr(data + byte_written, BASIC_IO_TEXT_END_MARK, n);
+		if (newline != NULL) {
+			n = (uint16_t)(newline - (data + byte_written)) + 1;
+		}
+
+		memcpy(line->buf + line->len, data + byte_written, n);
+		line->len += n;
+		byte_written += n;
+
+		if ((newline != NULL || line->len == BASIC_IO_LINE_BUFFER_SIZE)
+			&& _basic_io_line_flush(port, line) < 0) {
+			return -1;
 		}
 	}
 
 	return byte_written;
 }
+#endif
+
+int32_t basic_io_write(struct basic_io_port *port, char *data, uint16_t data_len, int block)
+{
+	port = _basic_io_port(port);
+	if (port == NULL || data == NULL
+		|| (port->ops->basic_io_port_write_no_block == NULL
+			&& port->ops->basic_io_port_write_byte_no_block == NULL)) {
+		return -1;
+	}
+
+#if (BASIC_IO_CONSOLE_LINE_BUFFER == 1)
+	struct _basic_io_line *line = _basic_io_line(port);
+	if (line != NULL && block) {
+		return _basic_io_line_write(port, line, data, data_len);
+	}
+#endif
+
+	return _basic_io_write(port, data, data_len, block);
+}
 
-int32_t basic_io_printf(const char *msg, ...)
+int32_t basic_io_flush(struct basic_io_port *port)
+{
+	port = _basic_io_port(port);
+	if (port == NULL) {
+		return -1;
+	}
+
+#if (BASIC_IO_CONSOLE_LINE_BUFFER == 1)
+	struct _basic_io_line *line = _basic_io_line(port);
+	if (line != NULL) {
+		return _basic_io_line_flush(port, line);
+	}
+#endif
+
+	return 0;
+}
+
+int32_t basic_io_writev(struct basic_io_port *port, const struct basic_io_vec *vec, int vec_count, int block)
+{
+	port = _basic_io_port(port);
+	if (port == NULL || vec == NULL || vec_count < 0) {
+		return -1;
+	}
+
+	int32_t total = 0;
+	int32_t cnt;
+	uint16_t offset = 0;
+	int i = 0;
+	int use_writev = (port->ops->basic_io_port_writev_no_block != NULL);
+#if (BASIC_IO_CONSOLE_LINE_BUFFER == 1)
+	/*
+	 * Buffered writes go piece by piece into the line buffer
+	 *
+	 * バッファリングされる書き込みは一片ずつ行バッファに入ります
+	 */
+	if (block && _basic_io_line(port) != NULL) {
+		use_writev = 0;
+	}
+#endif
+	if (use_writev) {
+		/*
+		 * Hand over all the pieces at once, then write the rest(if any)
+		 * piece by piece from where it stopped
+		 *
+		 * 全部の片を一度に渡して、残り（があれば）を止まった所から一片ずつ書き込みます
+		 */
+		cnt = port->ops->basic_io_port_writev_no_block(port->ctx, vec, vec_count);
+		if (cnt < 0) {
+			return cnt;
+		}
+		total = cnt;
+		while (i < vec_count && cnt >= vec[i].len) {
+			cnt -= vec[i].len;
+			i++;
+		}
+		offset = (uint16_t)cnt;
+		if (!block) {
+			return total;
+		}
+	}
+
+	while (i < vec_count) {
+		cnt = basic_io_write(port, (char *)(vec[i].data) + offset, vec[i].len - offset, block);
+		if (cnt < 0) {
+			break;
+		}
+		total += cnt;
+		if (cnt < vec[i].len - offset) {
+			break;
+		}
+		offset = 0;
+
+		i++;
+	}
+
+	return total;
+}
+
+struct _basic_io_printf_ctx {
+	struct basic_io_port *port;
+	int32_t written;
+};
+
+static void _basic_io_printf_output(void *ctx, const char *data, uint16_t len)
+{
+	struct _basic_io_printf_ctx *pc = (struct _basic_io_printf_ctx *)ctx;
+	int32_t ret;
+	if (pc->written < 0) {
+		return;
+	}
+
+	ret = basic_io_write(pc->port, (char *)data, len, 1);
+	if (ret < 0) {
+		pc->written = ret;
+	} else {
+		pc->written += ret;
+	}
+}
+
+int32_t basic_io_vprintf(struct basic_io_port *port, const char *msg, va_list ag)
+{
+	struct _basic_io_printf_ctx pc = {port, 0};
+	if (msg == NULL) {
+		return -1;
+	}
+
+	yfmt_vformat(_basic_io_printf_output, &pc, msg, ag);
+
+	return pc.written;
+}
+
+int32_t basic_io_printf(struct basic_io_port *port, const char *msg, ...)
 {
-	char buf[BASIC_IO_PRINTF_BUFFER_SIZE];
 	va_list ag;
 	va_start(ag, msg);
-	vsnprintf(buf, sizeof(buf), msg, ag);
+	int32_t ret = basic_io_vprintf(port, msg, ag);
 	va_end(ag);
-	buf[sizeof(buf) - 1] = '\0';
 
-	return basic_io_write(buf, strlen(buf), 1);
+	return ret;
+}
+
+#if (BASIC_IO_RETARGET_STDIO == 1)
+/*
+ * Called by newlib to write stdout/stderr
+ *
+ * stdout/stderrを書き込むためにnewlibから呼び出されます
+ */
+int _write(int file, char *ptr, int len)
+{
+	int32_t ret;
+	if (file != 1 && file != 2) {
+		errno = EBADF;
+		return -1;
+	}
+
+	if (len > 0xFFFF) {
+		len = 0xFFFF;
+	}
+
+	ret = basic_io_write(NULL, ptr, (uint16_t)len, 1);
+	if (ret < 0) {
+		errno = EIO;
+		return -1;
+	}
+
+	return (int)ret;
 }
+#endif
@@ -19,7 +19,75 @@ extern "C" {
 
 #define BASIC_IO_TEXT_END_MARK	'\n'
 
+/*
+ * Timeout for waiting forever
+ *
+ * ずっと待つ場合のタイムアウト
+ */
+#define BASIC_IO_WAIT_FOREVER	0xFFFF
+
+/*
+ * Return value when timed out
+ *
+ * タイムアウトした場合の戻り値
+ */
+#define BASIC_IO_RET_TIMEOUT	(-2)
+
+/*
+ * Modes of basic_io_port_wait_readable(), used by basic_io_read_timeout()
+ * and basic_io_readline_timeout() respectively
+ *
+ * basic_io_port_wait_readable()のモード、それぞれbasic_io_read_timeout()と
+ * basic_io_readline_timeout()が使います
+ */
+#define BASIC_IO_WAIT_ANY_BYTE	0
+#define BASIC_IO_WAIT_TEXT_END	1
+
+/*
+ * Blocking writes of tasks to the console are kept in a line buffer of
+ * each task, and written out at once with the console locked when a
+ * newline comes, the buffer gets full, or the task reads the console.
+ * Writes before yos_start(), from ISRs and not blocking ones go out directly.
+ *
+ * タスクのコンソールへのブロッキング書き込みはタスクごとの行バッファに保持され、
+ * 改行が来た時、バッファが満杯になった時、またはタスクがコンソールを読み込む時に
+ * コンソールをロックして一度に書き出されます
+ * yos_start()の前、ISRからとブロッキングでない書き込みは直接書き出されます
+ */
+#define BASIC_IO_CONSOLE_LINE_BUFFER	1
+#define BASIC_IO_LINE_BUFFER_SIZE		64
+
+/*
+ * Retarget newlib's _write() of stdout/stderr to the console,
+ * so that printf() goes the same way as basic_io_printf()
+ * Off by default, as it links newlib's stdio(setvbuf() and FILE),
+ * turn it on only if the application uses printf().
+ *
+ * stdout/stderrのnewlibの_write()をコンソールにリターゲットして、
+ * printf()もbasic_io_printf()と同じ経路を通るようにします
+ * newlibのstdio（setvbuf()とFILE）をリンクしますので、デフォルトはオフです
+ * アプリケーションがprintf()を使う場合のみオンにしてください
+ */
+#define BASIC_IO_RETARGET_STDIO			0
+
+/*
+ * One piece of data for basic_io_writev()
+ *
+ * basic_io_writev()用のデータの一片
+ */
+struct basic_io_vec {
+	const char *data;
+	uint16_t len;
+};
 
+
+/*
+ * Operations of a port. Every operation gets the ctx of the port as
+ * its first parameter, so one driver can serve several ports.
+ *
+ * ポートの操作。すべての操作は最初のパラメーターとしてポートのctxを受け取りますので、
+ * 一つのドライバーで複数のポートを扱えます
+ */
 struct basic_io_port_operations {
 	/*
 	 * Return 0 if init ok, or init is failed
@@ -27,7 +95,7 @@ struct basic_io_port_operations {
 	 * 0を戻る場合、初期化できました
 	 * その他の値を戻る場合、初期化できませんでした
 	 */
-	int (*basic_io_port_init)(void);
+	int (*basic_io_port_init)(void *ctx);
 
 	/*
 	 * Return 0 if deinit ok, or init is failed
@@ -35,7 +103,7 @@ struct basic_io_port_operations {
 	 * 0を戻る場合、終了できました
 	 * その他の値を戻る場合、終了できませんでした
 	 */
-	int (*basic_io_port_deinit)(void);
+	int (*basic_io_port_deinit)(void *ctx);
 
 	/*
 	 * Return non-zero(TRUE) means it can read, or zero(FALSE) means no data available
@@ -43,7 +111,7 @@ struct basic_io_port_operations {
 	 * 0以外の値（TRUE）を戻る場合、読み込めることになります
 	 * 0（FALSE）を戻る場合、今は読み込めないことになります
 	 */
-	int (*basic_io_port_can_read)(void);
+	int (*basic_io_port_can_read)(void *ctx);
 
 	/*
 	 * Return 0 if one byte is read and saved to b, other return values means error
@@ -53,7 +121,7 @@ struct basic_io_port_operations {
 	 * その他の値を戻る場合、読み込みエラーになります
 	 * この関数は読み込めるデータはなくても返却します、つまりブロックしません
 	 */
-	int (*basic_io_port_read_byte_no_block)(uint8_t *b);
+	int (*basic_io_port_read_byte_no_block)(void *ctx, uint8_t *b);
 
 	/*
 	 * Return non-zero(TRUE) means it can write, or zero(FALSE) means cannot write
@@ -61,7 +129,7 @@ struct basic_io_port_operations {
 	 * 0以外の値（TRUE）を戻る場合、書き込めることになります
 	 * 0（FALSE)を戻る場合、いま書き込めないことになります
 	 */
-	int (*basic_io_port_can_write)(void);
+	int (*basic_io_port_can_write)(void *ctx);
 
 	/*
 	 * Return 0 if one byte(b) is written, other return values means error
@@ -71,16 +139,103 @@ struct basic_io_port_operations {
 	 * その他の値を戻る場合、書き込みエラーになります
 	 * この関数は書き込めなくても返却します、つまりブロックしません
 	 */
-	int (*basic_io_port_write_byte_no_block)(uint8_t b);
+	int (*basic_io_port_write_byte_no_block)(void *ctx, uint8_t b);
+
+	/*
+	 * Optional, block until it can write. Return 0 if it can write now,
+	 * other return values means error.
+	 * If not given(NULL), a blocking write keeps retrying instead.
+	 *
+	 * オプション、書き込めるまでブロックします。0を戻る場合、今は書き込めることになります
+	 * その他の値を戻る場合、エラーになります
+	 * 指定しない（NULL）場合、ブロックする書き込みは代わりに再試行し続けます
+	 */
+	int (*basic_io_port_wait_writable)(void *ctx);
+
+	/*
+	 * Optional, block until it can read, for at most timeout_ms
+	 * (BASIC_IO_WAIT_FOREVER for no timeout).
+	 * With BASIC_IO_WAIT_ANY_BYTE it returns when any byte is there,
+	 * with BASIC_IO_WAIT_TEXT_END only when BASIC_IO_TEXT_END_MARK is there
+	 * (or no more can be received).
+	 * Return 0 if it can read now, BASIC_IO_RET_TIMEOUT if timed out,
+	 * other return values means error.
+	 * If not given(NULL), a blocking read keeps retrying instead.
+	 *
+	 * オプション、読み込めるまで最大timeout_msの間ブロックします
+	 * （タイムアウトなしはBASIC_IO_WAIT_FOREVER）
+	 * BASIC_IO_WAIT_ANY_BYTEの場合、何かのバイトがあれば戻ります
+	 * BASIC_IO_WAIT_TEXT_ENDの場合、BASIC_IO_TEXT_END_MARKがある（あるいはこれ以上受信できない）時のみ戻ります
+	 * 0を戻る場合、今は読み込めることになります
+	 * タイムアウトした場合BASIC_IO_RET_TIMEOUTを、その他の値を戻る場合、エラーになります
+	 * 指定しない（NULL）場合、ブロックする読み込みは代わりに再試行し続けます
+	 */
+	int (*basic_io_port_wait_readable)(void *ctx, int mode, uint16_t timeout_ms);
+
+	/*
+	 * Optional, read at most len bytes to buf. If stop_at_text_end is non-zero,
+	 * it stops right after BASIC_IO_TEXT_END_MARK is read.
+	 * Return the bytes read(0 if no data available), or minus value on error.
+	 * It will not block.
+	 * If not given(NULL), basic_io_port_read_byte_no_block is used byte by byte.
+	 *
+	 * オプション、最大lenバイトをbufに読み込みます。stop_at_text_endは0以外の場合、
+	 * BASIC_IO_TEXT_END_MARKを読み込んだ直後に止まります
+	 * 読み込んだバイト数（データがない場合0）を、エラーの場合負数を戻ります
+	 * この関数はブロックしません
+	 * 指定しない（NULL）場合、basic_io_port_read_byte_no_blockで一バイトずつ読み込みます
+	 */
+	int32_t (*basic_io_port_read_no_block)(void *ctx, uint8_t *buf, uint16_t len, int stop_at_text_end);
+
+	/*
+	 * Optional, write at most len bytes of data.
+	 * Return the bytes written(0 if cannot write now), or minus value on error.
+	 * It will not block.
+	 * If not given(NULL), basic_io_port_write_byte_no_block is used byte by byte.
+	 *
+	 * オプション、dataの最大lenバイトを書き込みます
+	 * 書き込んだバイト数（今書き込めない場合0）を、エラーの場合負数を戻ります
+	 * この関数はブロックしません
+	 * 指定しない（NULL）場合、basic_io_port_write_byte_no_blockで一バイトずつ書き込みます
+	 */
+	int32_t (*basic_io_port_write_no_block)(void *ctx, const uint8_t *data, uint16_t len);
+
+	/*
+	 * Optional, same as basic_io_port_write_no_block but for vec_count pieces
+	 * of data in order. Return the total bytes written, or minus value on error.
+	 * If not given(NULL), the pieces are written one by one.
+	 *
+	 * オプション、basic_io_port_write_no_blockと同じですが、vec_count個のデータを順番に書き込みます
+	 * 書き込んだ合計バイト数を、エラーの場合負数を戻ります
+	 * 指定しない（NULL）場合、一片ずつ書き込みます
+	 */
+	int32_t (*basic_io_port_writev_no_block)(void *ctx, const struct basic_io_vec *vec, int vec_count);
+};
+
+
+/*
+ * A port, i.e. one instance of a driver
+ * The functions below take it as their first parameter,
+ * where NULL means the console port(see basic_io_set_console()).
+ *
+ * ポート、つまりドライバーの一つのインスタンス
+ * 下記の関数は最初のパラメーターとして受け取ります
+ * NULLはコンソールのポート（basic_io_set_console()を参照）になります
+ */
+struct basic_io_port {
+	struct basic_io_port_operations *ops;
+	void *ctx;
 };
 
 
 /*
+ * Bind port to ops and ctx(passed to every operation), and init it
  * Return 0 if init ok
  *
+ * portをopsとctx（すべての操作に渡されます）に結び付けて、初期化します
  * 0を戻る場合、初期化できたことになります
  */
-int basic_io_init(struct basic_io_port_operations *ops);
+int basic_io_init(struct basic_io_port *port, struct basic_io_port_operations *ops, void *ctx);
 
 
 /*
@@ -88,7 +243,16 @@ int basic_io_init(struct basic_io_port_operations *ops);
  *
  * 0を戻る場合、終了できたことになります
  */
-int basic_io_deinit(void);
+int basic_io_deinit(struct basic_io_port *port);
+
+
+/*
+ * Set/get the console port, used when NULL is given as the port
+ *
+ * ポートとしてNULLを指定した場合に使われるコンソールのポートを設定／取得します
+ */
+void basic_io_set_console(struct basic_io_port *port);
+struct basic_io_port *basic_io_get_console(void);
 
 
 /*
@@ -97,7 +261,7 @@ int basic_io_deinit(void);
  * 0以外の値（TRUE）を戻る場合、読み込めることになります
  * その他の値を戻る場合、読み込めないことになります
  */
-int basic_io_has_data_to_read(void);
+int basic_io_has_data_to_read(struct basic_io_port *port);
 
 
 /*
@@ -108,7 +272,7 @@ int basic_io_has_data_to_read(void);
  * 0以外の値を戻る場合、読み込みエラーになります
  * 読み込めるデータはなくても、この関数は戻ります、つまりブロックしません
  */
-int basic_io_read_byte(uint8_t *byte_read);
+int basic_io_read_byte(struct basic_io_port *port, uint8_t *byte_read);
 
 
 /* Read data and save to buf with length of buf_len
@@ -123,7 +287,22 @@ int basic_io_read_byte(uint8_t *byte_read);
  * エラーが発生した場合、負数を戻ります
  * この関数はブロックしません
  */
-int32_t basic_io_read(char *buf, uint16_t buf_len);
+int32_t basic_io_read(struct basic_io_port *port, char *buf, uint16_t buf_len);
+
+
+/* Same as basic_io_read(), but if no data is available, waits for at most
+ * timeout_ms(BASIC_IO_WAIT_FOREVER for no timeout) until any byte comes.
+ *
+ * Return the bytes read(at least 1), or BASIC_IO_RET_TIMEOUT if timed out.
+ * If error occured, other minus value is returned.
+ *
+ * basic_io_read()と同じですが、読み込めるデータがない場合、
+ * 何かのバイトが来るまで最大timeout_msの間待ちます（タイムアウトなしはBASIC_IO_WAIT_FOREVER）
+ *
+ * 読み込んだバイト数（1以上）を、タイムアウトした場合BASIC_IO_RET_TIMEOUTを戻ります
+ * エラーが発生した場合、その他の負数を戻ります
+ */
+int32_t basic_io_read_timeout(struct basic_io_port *port, char *buf, uint16_t buf_len, uint16_t timeout_ms);
 
 
 /* Read data and save to buf until EOL or
@@ -151,7 +330,23 @@ int32_t basic_io_read(char *buf, uint16_t buf_len);
  * この関数はEOLを読み込むまで、または「buf_len」で指定するバイト数を読み込むまで戻りません
  * つまり、この関数はブロックすることをご注意ください
  */
-int32_t basic_io_readline(char *buf, uint16_t buf_len);
+int32_t basic_io_readline(struct basic_io_port *port, char *buf, uint16_t buf_len);
+
+
+/* Same as basic_io_readline(), but waits for at most timeout_ms
+ * (BASIC_IO_WAIT_FOREVER for no timeout) each time no data is available.
+ *
+ * If timed out before any byte is read, BASIC_IO_RET_TIMEOUT is returned.
+ * If timed out in the middle of a line, the bytes read so far are
+ * terminated with '\0' and the count is returned.
+ *
+ * basic_io_readline()と同じですが、読み込めるデータがない度に最大timeout_msの間待ちます
+ * （タイムアウトなしはBASIC_IO_WAIT_FOREVER）
+ *
+ * 一バイトも読み込む前にタイムアウトした場合、BASIC_IO_RET_TIMEOUTを戻ります
+ * 行の途中でタイムアウトした場合、今まで読み込んだバイトを'\0'で終端してそのバイト数を戻ります
+ */
+int32_t basic_io_readline_timeout(struct basic_io_port *port, char *buf, uint16_t buf_len, uint16_t timeout_ms);
 
 
 /* Write data with byte count of data_len,
@@ -178,11 +373,51 @@ int32_t basic_io_readline(char *buf, uint16_t buf_len);
  *
  * エラーが発生した場合、負数を戻ります
  */
-int32_t basic_io_write(char *data, uint16_t data_len, int block);
+int32_t basic_io_write(struct basic_io_port *port, char *data, uint16_t data_len, int block);
+
+
+/* Write vec_count pieces of data in order, like basic_io_write().
+ * Return the total byte count written.
+ *
+ * If error occured, minus value is returned.
+ *
+ * basic_io_write()のように、vec_count個のデータを順番に書き込みます
+ * 実際の書き込んだ合計バイト数を戻ります
+ *
+ * エラーが発生した場合、負数を戻ります
+ */
+int32_t basic_io_writev(struct basic_io_port *port, const struct basic_io_vec *vec, int vec_count, int block);
 
 
-#define BASIC_IO_PRINTF_BUFFER_SIZE			256
-int32_t basic_io_printf(const char *msg, ...);
+/* Write out what the calling task has in its console line buffer.
+ * Return the byte count written, 0 for other ports than the console.
+ *
+ * If error occured, minus value is returned.
+ *
+ * 呼び出したタスクのコンソールの行バッファにあるデータを書き出します
+ * 書き込んだバイト数を戻ります、コンソール以外のポートの場合0を戻ります
+ *
+ * エラーが発生した場合、負数を戻ります
+ */
+int32_t basic_io_flush(struct basic_io_port *port);
+
+
+/* Format by yfmt(see lib/yfmt/yfmt.h) and write to the port blocking.
+ * The text is written piece by piece as it is formatted,
+ * without any intermediate buffer for the whole text.
+ * Return the total byte count written.
+ *
+ * If error occured, minus value is returned.
+ *
+ * yfmt（lib/yfmt/yfmt.hを参照）でフォーマットしてポートへブロッキングで書き込みます
+ * テキストはフォーマットされながら一部分ずつ書き込まれ、
+ * テキスト全体の中間バッファは使いません
+ * 実際の書き込んだ合計バイト数を戻ります
+ *
+ * エラーが発生した場合、負数を戻ります
+ */
+int32_t basic_io_vprintf(struct basic_io_port *port, const char *msg, va_list ag);
+int32_t basic_io_printf(struct basic_io_port *port, const char *msg, ...);
 
 #ifdef __cplusplus
 }
@@ -17,6 +17,14 @@
 #include "../../src/yos/yos.h"
 #include "../../src/yos/common_def.h"
 
+#if (CMDLINE_SUPPORT_BENCH == 1)
+#include "../../src/yos/ybench.h"
+#endif
+
+#if (CMDLINE_SUPPORT_UART == 1)
+#include "../../src/ydevice/yusart.h"
+#endif
+
 #if (CMDLINE_SUPPORT_LFS == 1)
 #include "../yfs/yfs.h"
 #include "../yfs/yfs_data.h"
@@ -27,19 +35,15 @@ static volatile int _last_cmd_ret = 0;
 
 static void _cmd_printf(const char *msg, ...)
 {
-	char buf[CMDLINE_MAX_LENGTH];
 	va_list ag;
 	va_start(ag, msg);
-	vsnprintf(buf, sizeof(buf), msg, ag);
+	basic_io_vprintf(NULL, msg, ag);
 	va_end(ag);
-	buf[sizeof(buf) - 1] = '\0';
-
-	basic_io_write(buf, strlen(buf), 1);
 }
 
 static int _cmd_read_line(char *buf, uint16_t len)
 {
-	return basic_io_readline(buf, len);
+	return basic_io_readline(NULL, buf, len);
 }
 
 static int _search_char_in_string(const char c, const char *str)
@@ -310,6 +314,9 @@ static int _cmd_sys_info(int argc, char **argv)
 	_cmd_printf("sz float=%d\n", sizeof(float));
 	_cmd_printf("sz double=%d\n", sizeof(double));
 	_cmd_printf("sz void *=%d\n", sizeof(void *));
+	_cmd_printf("Preemption: %s\n", YOS_PREEMPTION ? "on" : "off");
+	_cmd_printf("Ticks: %lu\n", (unsigned long)yos_get_ticks());
+	_cmd_printf("Task switches: %lu\n", (unsigned long)yos_get_switch_count());
 
 	return 0;
 }
@@ -354,20 +361,212 @@ static int _cmd_step_motor(int argc, char **argv)
 
 static int _cmd_tasks_info(int argc, char **argv)
 {
-	_cmd_printf("ID    ST      SS     MSS    NAME\n");
+	_cmd_printf("ID    ST  PRI      SS     MSS    NAME\n");
 	struct yos_task_info ti;
 	int i = 0;
 	while (i < YOS_MAX_TASK_COUNT) {
 		if (yos_get_task_info(i, &ti) == 0) {
-			_cmd_printf("%03d   %2d    %4d    %4d    %s\n",
-					ti.id, ti.status, ti.stack_size, ti.stack_max_reached_size, ti.name);
+			_cmd_printf("%03d   %2d  %3u    %4d    %4d    %s\n",
+					ti.id, ti.status, ti.priority, ti.stack_size, ti.stack_max_reached_size, ti.name);
+		}
+
+		i++;
+	}
+
+#if (YOS_RECORD_CPU_USAGE == 1 || YOS_TASK_CPU_BUDGET == 1)
+#if (YOS_RECORD_CPU_USAGE == 1)
+	uint32_t total_run_ticks = 0;
+	i = 0;
+	while (i < YOS_MAX_TASK_COUNT) {
+		if (yos_get_task_info(i, &ti) == 0) {
+			total_run_ticks += ti.run_ticks;
 		}
 
 		i++;
 	}
+	if (total_run_ticks == 0) {
+		total_run_ticks = 1;
+	}
+#endif
+
+	_cmd_printf("\nID       RUN  CPU%%     BGT     PRD     THR");
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+	_cmd_printf("     TKT");
+#endif
+	_cmd_printf("\n");
+	i = 0;
+	while (i < YOS_MAX_TASK_COUNT) {
+		if (yos_get_task_info(i, &ti) == 0) {
+			_cmd_printf("%03d", ti.id);
+#if (YOS_RECORD_CPU_USAGE == 1)
+			_cmd_printf("  %8lu   %3lu", (unsigned long)ti.run_ticks,
+					(unsigned long)((uint64_t)ti.run_ticks * 100 / total_run_ticks));
+#else
+			_cmd_printf("         -     -");
+#endif
+#if (YOS_TASK_CPU_BUDGET == 1)
+			_cmd_printf("    %4u    %4u    %4u%s",
+					ti.budget_ms, ti.budget_period_ms, ti.throttle_count,
+					ti.is_throttled ? "*" : " ");
+#else
+			_cmd_printf("       -       -       - ");
+#endif
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+			_cmd_printf("   %5u", ti.tickets);
+#endif
+			_cmd_printf("\n");
+		}
+
+		i++;
+	}
+#endif
+
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_EDF)
+	int j;
+	_cmd_printf("\nID     PRD     DL     DLM    LATENESS\n");
+	i = 0;
+	while (i < YOS_MAX_TASK_COUNT) {
+		if (yos_get_task_info(i, &ti) == 0 && ti.period_ms > 0) {
+			_cmd_printf("%03d   %4u   %4u    %4u   ",
+					ti.id, ti.period_ms, ti.deadline_ms, ti.deadline_miss_count);
+			for (j = 0; j < YOS_EDF_LATENESS_BUCKETS; j++) {
+				_cmd_printf(" %u", ti.lateness_hist[j]);
+			}
+			_cmd_printf("\n");
+		}
+
+		i++;
+	}
+#endif
 	return 0;
 }
 
+/* usage: task suspend|resume <id>
+ *        task prio <id> <priority>
+ *
+ * Suspend/resume a task, or change its priority
+ */
+static int _cmd_task_ctrl(int argc, char **argv)
+{
+	int ret = -1;
+	int task_id;
+	if (argc >= 3) {
+		task_id = atoi(argv[2]);
+		if (strcmp(argv[1], "suspend") == 0) {
+			ret = yos_task_suspend(task_id);
+		} else if (strcmp(argv[1], "resume") == 0) {
+			ret = yos_task_resume(task_id);
+		} else if (strcmp(argv[1], "prio") == 0 && argc == 4) {
+			ret = yos_task_set_priority(task_id, atoi(argv[3]));
+		}
+	}
+
+	if (ret != 0) {
+		_cmd_printf("usage: task suspend|resume <id>\n");
+		_cmd_printf("       task prio <id> <0-%d>\n", YOS_TASK_PRIORITY_LEVELS - 1);
+	}
+
+	return ret;
+}
+
+#if (CMDLINE_SUPPORT_BENCH == 1)
+/* usage: bench [item]
+ *
+ * Run all benchmark items, or only the given one
+ */
+static int _cmd_bench(int argc, char **argv)
+{
+	int ret = 0;
+	int found = 0;
+	int i;
+	int cnt = ybench_get_count();
+	const char *name;
+
+	_cmd_printf("ITEM       CYCLES   STACK\n");
+	for (i = 0; i < cnt; i++) {
+		name = ybench_get_name(i);
+		if (argc >= 2 && strcmp(argv[1], name) != 0) {
+			continue;
+		}
+
+		found = 1;
+		_cmd_printf("%-8s   %6lu   %5lu\n", name, (unsigned long)ybench_run(i),
+					(unsigned long)ybench_run_stack(i));
+	}
+
+	if (!found) {
+#if (CMDLINE_OUTPUT_VERBOSE == 0)
+		_cmd_printf("unknown item\n");
+#else
+		_cmd_printf("%s Error: item %s not found\n", argv[0], argv[1]);
+#endif
+		ret = -1;
+	}
+
+	return ret;
+}
+#endif
+
+#if (CMDLINE_SUPPORT_UART == 1)
+static const char *_uart_flow_names[] = {"none", "rtscts", "xonxoff"};
+
+/* usage: uart
+ *        uart <no> baud <baudrate>
+ *        uart <no> flow none|rtscts|xonxoff
+ *
+ * Show counters of all the initialized USARTs,
+ * or change the baudrate/flow control of one
+ */
+static int _cmd_uart(int argc, char **argv)
+{
+	int ret = 0;
+	uint8_t no;
+	uint8_t flow;
+	struct yusart_stats stats;
+
+	if (argc == 4 && strcmp(argv[2], "baud") == 0) {
+		ret = yusart_set_baudrate((uint8_t)atoi(argv[1]), (uint32_t)strtoul(argv[3], NULL, 10));
+		if (ret != 0) {
+			_cmd_printf("%s Error: failed to set baudrate\n", argv[0]);
+		}
+		return ret;
+	} else if (argc == 4 && strcmp(argv[2], "flow") == 0) {
+		ret = -1;
+		for (flow = 0; flow < sizeof(_uart_flow_names) / sizeof(_uart_flow_names[0]); flow++) {
+			if (strcmp(argv[3], _uart_flow_names[flow]) == 0) {
+				ret = yusart_set_flow_control((uint8_t)atoi(argv[1]), flow);
+				break;
+			}
+		}
+		if (ret != 0) {
+			_cmd_printf("%s Error: failed to set flow control\n", argv[0]);
+		}
+		return ret;
+	} else if (argc != 1) {
+		_cmd_printf("usage: uart\n");
+		_cmd_printf("       uart <no> baud <baudrate>\n");
+		_cmd_printf("       uart <no> flow none|rtscts|xonxoff\n");
+		return -1;
+	}
+
+	_cmd_printf("NO BAUD     FLOW    RX       TX       ORE   NE    FE    PE    DROP  PAUSE\n");
+	for (no = 1; no <= 3; no++) {
+		if (yusart_get_stats(no, &stats) != 0) {
+			continue;
+		}
+		_cmd_printf("%-2u %-8lu %-7s %-8lu %-8lu %-5lu %-5lu %-5lu %-5lu %-5lu %lu\n",
+				no, (unsigned long)yusart_get_baudrate(no),
+				_uart_flow_names[yusart_get_flow_control(no)],
+				(unsigned long)stats.rx_bytes, (unsigned long)stats.tx_bytes,
+				(unsigned long)stats.overrun_errors, (unsigned long)stats.noise_errors,
+				(unsigned long)stats.framing_errors, (unsigned long)stats.parity_errors,
+				(unsigned long)stats.rx_dropped, (unsigned long)stats.rx_pauses);
+	}
+
+	return ret;
+}
+#endif
+
 static int _cmd_help(int argc, char **argv);
 
 #if (CMDLINE_OUTPUT_VERBOSE == 0)
@@ -385,6 +584,13 @@ static struct _cmd_info _cmd_list[] = {
 	CMD_INFO_ITEM(_cmd_step_motor, "sm", "Step Motor test"),
 #endif
 	CMD_INFO_ITEM(_cmd_tasks_info, "ts", "Show tasks info"),
+	CMD_INFO_ITEM(_cmd_task_ctrl, "task", "Suspend/resume task, set priority"),
+#if (CMDLINE_SUPPORT_BENCH == 1)
+	CMD_INFO_ITEM(_cmd_bench, "bench", "Run micro benchmarks"),
+#endif
+#if (CMDLINE_SUPPORT_UART == 1)
+	CMD_INFO_ITEM(_cmd_uart, "uart", "Show USART counters, set baudrate/flow control"),
+#endif
 	CMD_INFO_ITEM(_cmd_exit, CMDLINE_EXIT_CMD_NAME, "Exit cmdline")
 };
 
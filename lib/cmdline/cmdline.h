@@ -25,6 +25,20 @@ extern "C" {
 
 #define CMDLINE_OUTPUT_VERBOSE			1
 
+/*
+ * [bench] command to run micro benchmarks of YOS
+ *
+ * YOSのマイクロベンチマークを実行する「bench」コマンド
+ */
+#define CMDLINE_SUPPORT_BENCH			1
+
+/*
+ * [uart] command to show counters of USARTs and change their baudrate
+ *
+ * USARTのカウンターを表示して、ボーレートを変更する「uart」コマンド
+ */
+#define CMDLINE_SUPPORT_UART			1
+
 void do_cmdline(void);
 
 
@@ -0,0 +1,423 @@
+/*
+ * YFmt
+ *
+ * YFmt Source File
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include "yfmt.h"
+
+#define _YFMT_FLAG_LEFT					0x01
+#define _YFMT_FLAG_ZERO					0x02
+
+/*
+ * Enough for a 32 bit number with sign, or a %q number with 9 fraction digits
+ *
+ * 符号付き32ビット数、または9桁の小数部の%q数に十分なサイズ
+ */
+#define _YFMT_NUMBER_BUFFER_SIZE		24
+#define _YFMT_Q_MAX_PRECISION			9
+
+#define _YFMT_PAD_CHUNK_SIZE			8
+
+struct _yfmt_state {
+	yfmt_output_t output;
+	void *ctx;
+	int count;
+};
+
+struct _yfmt_buffer {
+	char *buf;
+	size_t size;
+	size_t pos;
+};
+
+static const char _yfmt_digits_lower[] = "0123456789abcdef";
+static const char _yfmt_digits_upper[] = "0123456789ABCDEF";
+static const char _yfmt_spaces[_YFMT_PAD_CHUNK_SIZE] = {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '};
+static const char _yfmt_zeros[_YFMT_PAD_CHUNK_SIZE] = {'0', '0', '0', '0', '0', '0', '0', '0'};
+
+static void _yfmt_put(struct _yfmt_state *st, const char *data, int len)
+{
+	if (len > 0) {
+		st->output(st->ctx, data, (uint16_t)len);
+		st->count += len;
+	}
+}
+
+/*
+ * Output count pad characters, in chunks from a constant table
+ *
+ * count個の埋め文字を、定数テーブルからチャンクごとに出力します
+ */
+static void _yfmt_pad(struct _yfmt_state *st, const char *pad, int count)
+{
+	int chunk;
+	while (count > 0) {
+		chunk = (count > _YFMT_PAD_CHUNK_SIZE) ? _YFMT_PAD_CHUNK_SIZE : count;
+		_yfmt_put(st, pad, chunk);
+		count -= chunk;
+	}
+}
+
+/*
+ * Output prefix(sign) and body padded to width
+ * Zero padding is put between prefix and body.
+ *
+ * プレフィックス（符号）と本体を幅まで埋めて出力します
+ * ゼロ埋めはプレフィックスと本体の間に入ります
+ */
+static void _yfmt_put_field(struct _yfmt_state *st, const char *prefix, int prefix_len,
+						const char *body, int body_len, int width, int flags)
+{
+	int pad = width - prefix_len - body_len;
+	if (pad < 0) {
+		pad = 0;
+	}
+
+	if (flags & _YFMT_FLAG_LEFT) {
+		_yfmt_put(st, prefix, prefix_len);
+		_yfmt_put(st, body, body_len);
+		_yfmt_pad(st, _yfmt_spaces, pad);
+	} else if (flags & _YFMT_FLAG_ZERO) {
+		_yfmt_put(st, prefix, prefix_len);
+		_yfmt_pad(st, _yfmt_zeros, pad);
+		_yfmt_put(st, body, body_len);
+	} else {
+		_yfmt_pad(st, _yfmt_spaces, pad);
+		_yfmt_put(st, prefix, prefix_len);
+		_yfmt_put(st, body, body_len);
+	}
+}
+
+/*
+ * Output an integer, sign(0 for none) and digits, with leading zeros up to
+ * precision digits, padded to width
+ * The leading zeros are output by _yfmt_pad(), not put in the number
+ * buffer, so any precision is fine. Like printf, '0' flag is ignored
+ * if precision is given.
+ *
+ * 整数、符号（なしは0）と数字を、精度の桁数まで先頭にゼロを付け、幅まで埋めて出力します
+ * 先頭のゼロは数字バッファに入れずに_yfmt_pad()で出力しますので、精度はいくつでも大丈夫です
+ * printfと同じく、精度が指定された場合'0'フラグは無視されます
+ */
+static void _yfmt_put_number(struct _yfmt_state *st, char sign, const char *digits, int len,
+							int precision, int width, int flags)
+{
+	int sign_len = (sign != 0) ? 1 : 0;
+	int zeros = (precision > len) ? precision - len : 0;
+	int pad = width - sign_len - zeros - len;
+	if (pad < 0) {
+		pad = 0;
+	}
+
+	if (flags & _YFMT_FLAG_LEFT) {
+		_yfmt_put(st, &sign, sign_len);
+		_yfmt_pad(st, _yfmt_zeros, zeros);
+		_yfmt_put(st, digits, len);
+		_yfmt_pad(st, _yfmt_spaces, pad);
+	} else if ((flags & _YFMT_FLAG_ZERO) && precision < 0) {
+		_yfmt_put(st, &sign, sign_len);
+		_yfmt_pad(st, _yfmt_zeros, pad);
+		_yfmt_put(st, digits, len);
+	} else {
+		_yfmt_pad(st, _yfmt_spaces, pad);
+		_yfmt_put(st, &sign, sign_len);
+		_yfmt_pad(st, _yfmt_zeros, zeros);
+		_yfmt_put(st, digits, len);
+	}
+}
+
+/*
+ * Convert value to digits backwards from end, with at least min_digits digits.
+ * If point_pos is not 0, '.' is put after the lowest point_pos digits.
+ * Return the start of the digits.
+ *
+ * valueをendから後ろ向きに、最低min_digits桁の数字に変換します
+ * point_posが0でなければ、下位point_pos桁の後ろに'.'を入れます
+ * 数字の先頭を戻ります
+ */
+static char *_yfmt_utoa(char *end, uint32_t value, int is_hex, const char *digits,
+						int min_digits, int point_pos)
+{
+	char *p = end;
+	int n = 0;
+	do {
+		if (is_hex) {
+			*--p = digits[value & 0x0F];
+			value >>= 4;
+		} else {
+			*--p = digits[value % 10];
+			value /= 10;
+		}
+		n++;
+		if (n == point_pos) {
+			*--p = '.';
+		}
+	} while (value != 0 || n < min_digits);
+
+	return p;
+}
+
+int yfmt_vformat(yfmt_output_t output, void *ctx, const char *fmt, va_list ap)
+{
+	if (output == NULL || fmt == NULL) {
+		return -1;
+	}
+
+	struct _yfmt_state st = {output, ctx, 0};
+	char num_buf[_YFMT_NUMBER_BUFFER_SIZE];
+	char *num_end = num_buf + sizeof(num_buf);
+	const char *literal;
+	const char *spec;
+	const char *str;
+	char *p;
+	char sign;
+	char ch;
+	char conv;
+	int flags;
+	int width;
+	int precision;
+	int length;
+	int len;
+	int32_t sval;
+	uint32_t uval;
+
+	while (*fmt != '\0') {
+		/*
+		 * Literal text up to the next '%' is output as it is
+		 *
+		 * 次の'%'までのリテラルテキストはそのまま出力します
+		 */
+		literal = fmt;
+		while (*fmt != '\0' && *fmt != '%') {
+			fmt++;
+		}
+		_yfmt_put(&st, literal, (int)(fmt - literal));
+		if (*fmt == '\0') {
+			break;
+		}
+
+		spec = fmt;
+		fmt++;
+
+		flags = 0;
+		while (1) {
+			if (*fmt == '-') {
+				flags |= _YFMT_FLAG_LEFT;
+			} else if (*fmt == '0') {
+				flags |= _YFMT_FLAG_ZERO;
+			} else {
+				break;
+			}
+			fmt++;
+		}
+
+		width = 0;
+		if (*fmt == '*') {
+			width = va_arg(ap, int);
+			if (width < 0) {
+				flags |= _YFMT_FLAG_LEFT;
+				width = -width;
+			}
+			fmt++;
+		} else {
+			while (*fmt >= '0' && *fmt <= '9') {
+				width = width * 10 + (*fmt - '0');
+				fmt++;
+			}
+		}
+
+		precision = -1;
+		if (*fmt == '.') {
+			fmt++;
+			precision = 0;
+			if (*fmt == '*') {
+				precision = va_arg(ap, int);
+				fmt++;
+			} else {
+				while (*fmt >= '0' && *fmt <= '9') {
+					precision = precision * 10 + (*fmt - '0');
+					fmt++;
+				}
+			}
+		}
+
+		/*
+		 * Length modifier, 2 for hh, 1 for h, 'l' and 'z' for l and z
+		 *
+		 * 長さ修飾子、hhは2、hは1、lとzは'l'と'z'
+		 */
+		length = 0;
+		if (*fmt == 'h') {
+			length = 1;
+			fmt++;
+			if (*fmt == 'h') {
+				length = 2;
+				fmt++;
+			}
+		} else if (*fmt == 'l' || *fmt == 'z') {
+			length = *fmt;
+			fmt++;
+		}
+
+		conv = *fmt;
+		if (conv == '\0') {
+			_yfmt_put(&st, spec, (int)(fmt - spec));
+			break;
+		}
+		fmt++;
+
+		switch (conv) {
+		case 'd':
+		case 'i':
+		case 'q':
+			if (length == 'l') {
+				sval = (int32_t)va_arg(ap, long);
+			} else if (length == 'z') {
+				sval = (int32_t)va_arg(ap, size_t);
+			} else {
+				sval = (int32_t)va_arg(ap, int);
+				if (length == 1) {
+					sval = (int16_t)sval;
+				} else if (length == 2) {
+					sval = (int8_t)sval;
+				}
+			}
+
+			sign = 0;
+			uval = (uint32_t)sval;
+			if (sval < 0) {
+				sign = '-';
+				uval = 0U - uval;
+			}
+
+			if (conv == 'q') {
+				if (precision < 0) {
+					precision = 1;
+				} else if (precision > _YFMT_Q_MAX_PRECISION) {
+					precision = _YFMT_Q_MAX_PRECISION;
+				}
+				p = (precision == 0) ? _yfmt_utoa(num_end, uval, 0, _yfmt_digits_lower, 1, 0)
+						: _yfmt_utoa(num_end, uval, 0, _yfmt_digits_lower, precision + 1, precision);
+				_yfmt_put_field(&st, &sign, (sign != 0) ? 1 : 0, p, (int)(num_end - p), width, flags);
+			} else {
+				p = _yfmt_utoa(num_end, uval, 0, _yfmt_digits_lower, 1, 0);
+				_yfmt_put_number(&st, sign, p, (int)(num_end - p), precision, width, flags);
+			}
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+			if (length == 'l') {
+				uval = (uint32_t)va_arg(ap, unsigned long);
+			} else if (length == 'z') {
+				uval = (uint32_t)va_arg(ap, size_t);
+			} else {
+				uval = (uint32_t)va_arg(ap, unsigned int);
+				if (length == 1) {
+					uval = (uint16_t)uval;
+				} else if (length == 2) {
+					uval = (uint8_t)uval;
+				}
+			}
+
+			p = _yfmt_utoa(num_end, uval, (conv != 'u'),
+						(conv == 'X') ? _yfmt_digits_upper : _yfmt_digits_lower, 1, 0);
+			_yfmt_put_number(&st, 0, p, (int)(num_end - p), precision, width, flags);
+			break;
+		case 'c':
+			ch = (char)va_arg(ap, int);
+			_yfmt_put_field(&st, NULL, 0, &ch, 1, width, flags & _YFMT_FLAG_LEFT);
+			break;
+		case 's':
+			str = va_arg(ap, const char *);
+			if (str == NULL) {
+				str = "(null)";
+			}
+			len = 0;
+			while (str[len] != '\0' && (precision < 0 || len < precision)) {
+				len++;
+			}
+			_yfmt_put_field(&st, NULL, 0, str, len, width, flags & _YFMT_FLAG_LEFT);
+			break;
+		case '%':
+			_yfmt_put(&st, "%", 1);
+			break;
+		default:
+			/*
+			 * Unsupported conversion is output as it is
+			 *
+			 * サポートしない変換はそのまま出力します
+			 */
+			_yfmt_put(&st, spec, (int)(fmt - spec));
+			break;
+		}
+	}
+
+	return st.count;
+}
+
+int yfmt_format(yfmt_output_t output, void *ctx, const char *fmt, ...)
+{
+	va_list ap;
+	va_start(ap, fmt);
+	int ret = yfmt_vformat(output, ctx, fmt, ap);
+	va_end(ap);
+
+	return ret;
+}
+
+static void _yfmt_buffer_output(void *ctx, const char *data, uint16_t len)
+{
+	struct _yfmt_buffer *b = (struct _yfmt_buffer *)ctx;
+	size_t room = b->size - 1 - b->pos;
+	if (len > room) {
+		len = (uint16_t)room;
+	}
+
+	memcpy(b->buf + b->pos, data, len);
+	b->pos += len;
+}
+
+/*
+ * Only counts the characters, for size 0
+ *
+ * サイズ0のため、文字数を数えるのみです
+ */
+static void _yfmt_null_output(void *ctx, const char *data, uint16_t len)
+{
+}
+
+int yfmt_vsnprintf(char *buf, size_t size, const char *fmt, va_list ap)
+{
+	if (size == 0) {
+		return yfmt_vformat(_yfmt_null_output, NULL, fmt, ap);
+	}
+
+	if (buf == NULL) {
+		return -1;
+	}
+
+	struct _yfmt_buffer b = {buf, size, 0};
+	int ret = yfmt_vformat(_yfmt_buffer_output, &b, fmt, ap);
+	buf[b.pos] = '\0';
+
+	return ret;
+}
+
+int yfmt_snprintf(char *buf, size_t size, const char *fmt, ...)
+{
+	va_list ap;
+	va_start(ap, fmt);
+	int ret = yfmt_vsnprintf(buf, size, fmt, ap);
+	va_end(ap);
+
+	return ret;
+}
@@ -0,0 +1,82 @@
+/*
+ * YFmt
+ *
+ * YFmt Header File
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#ifndef _Y_FMT_H_
+#define _Y_FMT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Compact printf style formatter for integers, hex, strings and fixed-point,
+ * no floating point and no 64 bit integers.
+ *
+ * Conversions: %d %i %u %x %X %c %s %% and %q
+ * Flags: '-'(left align) and '0'(zero padding)
+ * Width and precision: number or '*'
+ * Length modifiers: hh h l z(all are 32 bit or narrower)
+ *
+ * %q prints a fixed-point number, that is a signed integer scaled by
+ * 10^precision, e.g. ("%.1q", 235) prints "23.5", ("%.2q", -5) prints "-0.05".
+ * Precision of %q is 1 if omitted, and at most 9.
+ *
+ * 整数、16進数、文字列と固定小数点のためのコンパクトなprintf形式のフォーマッタ
+ * 浮動小数点と64ビット整数はサポートしません
+ *
+ * 変換：%d %i %u %x %X %c %s %% と %q
+ * フラグ：'-'（左寄せ）と'0'（ゼロ埋め）
+ * 幅と精度：数字か'*'
+ * 長さ修飾子：hh h l z（すべて32ビット以下）
+ *
+ * %qは固定小数点数、つまり10^精度倍された符号付き整数を出力します
+ * 例：("%.1q", 235)は"23.5"を、("%.2q", -5)は"-0.05"を出力します
+ * %qの精度は省略した場合1で、最大9です
+ */
+
+/*
+ * Output function called for each piece of the formatted text
+ *
+ * フォーマットされたテキストの各部分ごとに呼び出される出力関数
+ */
+typedef void (*yfmt_output_t)(void *ctx, const char *data, uint16_t len);
+
+/*
+ * Format and pass the text piece by piece to output, without any
+ * intermediate buffer for the whole text.
+ * Return the count of characters output.
+ *
+ * フォーマットして、テキスト全体の中間バッファなしで、一部分ずつoutputに渡します
+ * 出力した文字数を戻ります
+ */
+int yfmt_vformat(yfmt_output_t output, void *ctx, const char *fmt, va_list ap);
+int yfmt_format(yfmt_output_t output, void *ctx, const char *fmt, ...);
+
+/*
+ * Format into buf like vsnprintf()/snprintf(), the result is always
+ * terminated by '\0' if size is not 0. With size 0 nothing is written
+ * and buf can be NULL.
+ * Return the count of characters of the whole text(not truncated).
+ *
+ * vsnprintf()/snprintf()のようにbufへフォーマットします
+ * sizeが0でなければ、結果は必ず'\0'で終わります
+ * sizeが0の場合何も書き込まず、bufはNULLでも構いません
+ * テキスト全体（切り詰められる前）の文字数を戻ります
+ */
+int yfmt_vsnprintf(char *buf, size_t size, const char *fmt, va_list ap);
+int yfmt_snprintf(char *buf, size_t size, const char *fmt, ...);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -7,14 +7,17 @@
 
 #include <libopencm3/stm32/rcc.h>
 #include <stdint.h>
-#include <stdio.h>
 #include "ydevice/yiic.h"
 #include "ydevice/yusart.h"
 #include "yos/yos.h"
+#include "yos/ybus.h"
 #include "yos/ytimer.h"
+#include "yos/ylog.h"
+#include "yos/ybench.h"
 #include "../lib/AVR_aht20/src/aht20.h"
 #include "../lib/cmdline/basic_io.h"
 #include "../lib/cmdline/cmdline.h"
+#include "../lib/yfmt/yfmt.h"
 #include "../lib/ssd1306xled/ssd1306xled/ssd1306xled.h"
 #include "../lib/ssd1306xled/ssd1306xled/yos_ssd1306_font.h"
 
@@ -22,6 +25,18 @@
 #define HAS_AHT20_SENSOR		1
 #define HAS_SSD1306_OLED		1
 
+/*
+ * Ship YLOG() records in binary on USART2(YUSART_ENABLE_USART2 in yusart.h)
+ *
+ * YLOG()のレコードをUSART2でバイナリで送ります（yusart.hのYUSART_ENABLE_USART2）
+ */
+#define HAS_BINARY_LOG			0
+#define BINARY_LOG_BAUDRATE		921600
+
+static struct basic_io_port _console_port;
+#if (HAS_BINARY_LOG == 1)
+static struct basic_io_port _log_port;
+#endif
 
 static void system_clock_setup(void)
 {
@@ -38,13 +53,27 @@ static int _cmdline_task(void *para)
 }
 
 #if (HAS_AHT20_SENSOR == 1)
-static int8_t _temperature = 0;
-static uint8_t _humidity = 0;
+struct _sensor_values {
+	int8_t temperature;
+	uint8_t humidity;
+};
+
+/*
+ * Notification bit sent to subscribers when new sensor values are published
+ *
+ * 新しいセンサー値がパブリッシュされた時にサブスクライバーに送る通知ビット
+ */
+#define _NOTIFY_SENSOR_VALUES		(1UL << 0)
+
+YBUS_TOPIC_DEFINE(_sensor_topic, struct _sensor_values, _NOTIFY_SENSOR_VALUES);
+
 static void _ath20_event_cb(int8_t temperature, uint8_t humidity, enum AHT20_STATUS status)
 {
+	struct _sensor_values values;
 	if (status == AHT20_SUCCESS) {
-		_temperature = temperature;
-		_humidity = humidity;
+		values.temperature = temperature;
+		values.humidity = humidity;
+		YBUS_PUBLISH(_sensor_topic, values);
 	}
 }
 
@@ -58,7 +87,6 @@ static int _aht20_task(void *para)
 		aht20_event();
 
 		yos_task_msleep(1000);
-		//basic_io_printf("aht20 task last read: Temp=%d, Humidity=%d%%\n", _temperature, _humidity);
 	}
 
 	return 0;
@@ -68,8 +96,16 @@ static int _aht20_task(void *para)
 #if (HAS_SSD1306_OLED == 1)
 static int _oled_task(void *para)
 {
-	uint8_t dd, hh, mm, ss;
-	dd = hh = mm = ss = 0;
+	uint32_t ticks;
+	uint32_t uptime_s;
+	uint32_t last_uptime_s = 0xFFFFFFFF;
+	uint16_t dd;
+	uint8_t hh, mm, ss;
+	uint16_t wait_ms;
+#if (HAS_AHT20_SENSOR == 1)
+	struct _sensor_values values;
+	int is_sensor_updated = 1;
+#endif
 	char buf[16];
 	int invert = 0;
 
@@ -77,59 +113,82 @@ static int _oled_task(void *para)
 	ssd1306_clear();
 	yos_ssd1306_puts(YOS_SSD1306_FONT_6X8, 0, 0, "YOS OLED");
 
+#if (HAS_AHT20_SENSOR == 1)
+	ybus_subscribe(&_sensor_topic);
+#endif
+
 	while (1) {
-		if (ss == 60) {
-			ss = 0;
-			mm++;
-			if (mm == 60) {
-				mm = 0;
-				hh++;
-				if (hh == 24) {
-					hh = 0;
-					dd++;
-				}
+		/*
+		 * Uptime is taken from the kernel ticks, so it does not drift
+		 * however long drawing takes
+		 *
+		 * 稼働時間はカーネルのtickから取りますので、描画に時間がかかってもずれません
+		 */
+		ticks = yos_get_ticks();
+		uptime_s = ticks / YOS_TICK_HZ;
+		if (uptime_s != last_uptime_s) {
+			last_uptime_s = uptime_s;
+			ss = uptime_s % 60;
+			mm = (uptime_s / 60) % 60;
+			hh = (uptime_s / 3600) % 24;
+			dd = (uint16_t)(uptime_s / 86400);
+
+			yfmt_snprintf(buf, sizeof(buf), "%03u D", dd);
+			yos_ssd1306_puts(YOS_SSD1306_FONT_6X8,
+							yos_ssd1306_char_col_to_pixel(YOS_SSD1306_FONT_6X8, 0),
+							2, buf);
+
+			yfmt_snprintf(buf, sizeof(buf), "%02u H", hh);
+			yos_ssd1306_puts(YOS_SSD1306_FONT_6X8,
+							yos_ssd1306_char_col_to_pixel(YOS_SSD1306_FONT_6X8, 6),
+							2, buf);
+
+			yfmt_snprintf(buf, sizeof(buf), "%02u M", mm);
+			yos_ssd1306_puts(YOS_SSD1306_FONT_6X8,
+							yos_ssd1306_char_col_to_pixel(YOS_SSD1306_FONT_6X8, 11),
+							2, buf);
+
+			yfmt_snprintf(buf, sizeof(buf), "%02u S", ss);
+			yos_ssd1306_puts(YOS_SSD1306_FONT_6X8,
+							yos_ssd1306_char_col_to_pixel(YOS_SSD1306_FONT_6X8, 16),
+							2, buf);
+
+			if (ss == 0) {
+				ssd1306_display_invert(invert);
+				invert = !invert;
 			}
 		}
 
-		snprintf(buf, sizeof(buf), "%03u D", dd);
-		yos_ssd1306_puts(YOS_SSD1306_FONT_6X8,
-						yos_ssd1306_char_col_to_pixel(YOS_SSD1306_FONT_6X8, 0),
-						2, buf);
-
-		snprintf(buf, sizeof(buf), "%02u H", hh);
-		yos_ssd1306_puts(YOS_SSD1306_FONT_6X8,
-						yos_ssd1306_char_col_to_pixel(YOS_SSD1306_FONT_6X8, 6),
-						2, buf);
-
-		snprintf(buf, sizeof(buf), "%02u M", mm);
-		yos_ssd1306_puts(YOS_SSD1306_FONT_6X8,
-						yos_ssd1306_char_col_to_pixel(YOS_SSD1306_FONT_6X8, 11),
-						2, buf);
-
-		snprintf(buf, sizeof(buf), "%02u S", ss);
-		yos_ssd1306_puts(YOS_SSD1306_FONT_6X8,
-						yos_ssd1306_char_col_to_pixel(YOS_SSD1306_FONT_6X8, 16),
-						2, buf);
-
 #if (HAS_AHT20_SENSOR == 1)
-		snprintf(buf, sizeof(buf), "T: %3d", _temperature);
-		yos_ssd1306_puts(YOS_SSD1306_FONT_6X8,
-						yos_ssd1306_char_col_to_pixel(YOS_SSD1306_FONT_6X8, 0),
-						4, buf);
-
-		snprintf(buf, sizeof(buf), "H: %3u%%", _humidity);
-		yos_ssd1306_puts(YOS_SSD1306_FONT_6X8,
-						yos_ssd1306_char_col_to_pixel(YOS_SSD1306_FONT_6X8, 8),
-						4, buf);
-#endif
-
-		if (ss == 0) {
-			ssd1306_display_invert(invert);
-			invert = !invert;
+		/*
+		 * Redraw sensor values only when new ones are published
+		 *
+		 * 新しいセンサー値がパブリッシュされた時のみ再描画します
+		 */
+		if (is_sensor_updated && YBUS_READ(_sensor_topic, values, NULL) == 0) {
+			yfmt_snprintf(buf, sizeof(buf), "T: %3d", values.temperature);
+			yos_ssd1306_puts(YOS_SSD1306_FONT_6X8,
+							yos_ssd1306_char_col_to_pixel(YOS_SSD1306_FONT_6X8, 0),
+							4, buf);
+
+			yfmt_snprintf(buf, sizeof(buf), "H: %3u%%", values.humidity);
+			yos_ssd1306_puts(YOS_SSD1306_FONT_6X8,
+							yos_ssd1306_char_col_to_pixel(YOS_SSD1306_FONT_6X8, 8),
+							4, buf);
 		}
+#endif
 
-		yos_task_msleep(1000);
-		ss++;
+		/*
+		 * Wait until the next second
+		 *
+		 * 次の秒まで待ちます
+		 */
+		wait_ms = 1000 - (ticks % YOS_TICK_HZ) * 1000 / YOS_TICK_HZ;
+#if (HAS_AHT20_SENSOR == 1)
+		is_sensor_updated = (yos_task_notify_wait(_NOTIFY_SENSOR_VALUES, wait_ms) != 0);
+#else
+		yos_task_msleep(wait_ms);
+#endif
 	}
 
 	return 0;
@@ -141,39 +200,68 @@ int main(void)
 	system_clock_setup();
 	user_timer_init();
 
-	if (basic_io_init(yusart_io_operations) != 0) {
+	if (basic_io_init(&_console_port, yusart_io_operations,
+						yusart_io_context(1, USART_BAUDRATE)) != 0) {
 		return -1;
 	}
+	basic_io_set_console(&_console_port);
+
+#if (HAS_BINARY_LOG == 1)
+	if (basic_io_init(&_log_port, yusart_io_operations,
+						yusart_io_context(2, BINARY_LOG_BAUDRATE)) != 0) {
+		basic_io_printf(NULL, "Log port init failed\n");
+		return -1;
+	}
+	ylog_set_port(&_log_port);
+#endif
 
 	if (yiic_master_init(100000) != 0) {
-		basic_io_printf("IIC master init failed\n");
+		basic_io_printf(NULL, "IIC master init failed\n");
 		return -1;
 	}
 
-	basic_io_printf("-------------\n");
-	basic_io_printf("YOS starts on STM32\n");
+	basic_io_printf(NULL, "-------------\n");
+	basic_io_printf(NULL, "YOS starts on STM32\n");
 
 	yos_init();
 
 	if (yos_create_task(_cmdline_task, NULL, 1024, "cmdtask") < 0) {
-		basic_io_printf("Failed to create cmdline task\n");
+		basic_io_printf(NULL, "Failed to create cmdline task\n");
 		return -1;
 	}
 
 #if (HAS_SSD1306_OLED == 1)
 	if (yos_create_task(_oled_task, NULL, 1024, "oledtak") < 0) {
-		basic_io_printf("Failed to create oled task\n");
+		basic_io_printf(NULL, "Failed to create oled task\n");
 		return -1;
 	}
 #endif
 
 #if (HAS_AHT20_SENSOR == 1)
 	if (yos_create_task(_aht20_task, NULL, 1024, "ahttsk") < 0 ) {
-		basic_io_printf("Failed to create aht20 task\n");
+		basic_io_printf(NULL, "Failed to create aht20 task\n");
 		return -1;
 	}
 #endif
 
+#if (HAS_BINARY_LOG == 1)
+	if (yos_create_task(ylog_task, NULL, 512, "logtask") < 0) {
+		basic_io_printf(NULL, "Failed to create log task\n");
+		return -1;
+	}
+#endif
+
+#if (CMDLINE_SUPPORT_BENCH == 1 && YBENCH_WITH_LOAD_TASKS == 1)
+	/*
+	 * Not fatal, only the ld_* bench items cannot run then
+	 *
+	 * 致命的ではありません、その場合ld_*ベンチ項目のみ実行できません
+	 */
+	if (ybench_create_load_tasks() != 0) {
+		basic_io_printf(NULL, "Failed to create bench load tasks\n");
+	}
+#endif
+
 	yos_start();
 
 	/*
@@ -12,6 +12,7 @@
 #include <libopencm3/stm32/rcc.h>
 #include <stdio.h>
 #include "../yos/common_def.h"
+#include "../yos/yos.h"
 #include "../yos/ymutex.h"
 #include "yiic.h"
 
@@ -61,7 +62,13 @@ int yiic_master_init(uint32_t iic_freq)
 
 	i2c_peripheral_enable(DEFAULT_IIC);
 
-	ymutex_init(&_yiic_mutex);
+	/*
+	 * Recursive, so that helpers can start a transfer again(repeated start)
+	 * inside one already started
+	 *
+	 * 再帰mutexなので、開始済みの転送の中でヘルパーが再び転送を開始できます（リピートスタート）
+	 */
+	ymutex_init_recursive(&_yiic_mutex);
 
 	return 0;
 }
@@ -85,16 +92,42 @@ void yiic_master_wait(void)
 
 static uint8_t volatile addr_for_current_trans = 0;
 static enum yiic_master_tr volatile current_tran_type = YIIC_MASTER_TRANSMIT;
+
+/*
+ * How many transfers are started and not stopped by the mutex owner,
+ * more than 1 means nested ones(repeated start)
+ *
+ * mutexの所有者が開始してまだ停止していない転送の数、
+ * 1より大きい場合はネストした転送（リピートスタート）です
+ */
+static uint16_t _yiic_nesting = 0;
+
 int yiic_master_trans_start(enum yiic_master_tr tran_type)
 {
-	ymutex_lock(&_yiic_mutex);
+	return yiic_master_trans_start_timeout(tran_type, YOS_WAIT_FOREVER);
+}
+
+int yiic_master_trans_start_timeout(enum yiic_master_tr tran_type, uint16_t timeout_ms)
+{
+	int ret = ymutex_lock_timeout(&_yiic_mutex, timeout_ms);
+	if (ret != 0) {
+		return (ret == YMUTEX_RET_TIMEOUT) ? YIIC_RET_TIMEOUT : -1;
+	}
 
 	current_tran_type = tran_type;
-	if (current_tran_type == YIIC_MASTER_TRANSMIT) {
+	if (_yiic_nesting == 0 && current_tran_type == YIIC_MASTER_TRANSMIT) {
 		while ((I2C_SR2(DEFAULT_IIC) & I2C_SR2_BUSY)) {
 		}
 	}
 
+	/*
+	 * Inside a started transfer the bus is still ours(BUSY),
+	 * so this is sent as a repeated start
+	 *
+	 * 開始済みの転送の中ではバスはまだ自分のもの（BUSY）ですので、
+	 * これはリピートスタートとして送られます
+	 */
+	_yiic_nesting++;
 	i2c_send_start(DEFAULT_IIC);
 
 	if (current_tran_type == YIIC_MASTER_RECEIVE) {
@@ -106,7 +139,19 @@ int yiic_master_trans_start(enum yiic_master_tr tran_type)
 
 int yiic_master_trans_stop(void)
 {
-	i2c_send_stop(DEFAULT_IIC);
+	if (_yiic_mutex.owner != yos_get_current_task_id() || _yiic_nesting == 0) {
+		return -1;
+	}
+
+	/*
+	 * Only the outermost transfer releases the bus
+	 *
+	 * 一番外側の転送のみバスを解放します
+	 */
+	_yiic_nesting--;
+	if (_yiic_nesting == 0) {
+		i2c_send_stop(DEFAULT_IIC);
+	}
 
 	ymutex_unlock(&_yiic_mutex);
 
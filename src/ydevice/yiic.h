@@ -23,7 +23,37 @@ int yiic_master_init(uint32_t iic_freq);
 int yiic_master_deinit(void);
 
 void yiic_master_wait(void);
+/*
+ * Return value of yiic_master_trans_start_timeout() when timed out
+ *
+ * タイムアウトした時のyiic_master_trans_start_timeout()の戻り値
+ */
+#define YIIC_RET_TIMEOUT			-2
+
+/*
+ * Start a transfer, taking the bus for the calling task.
+ * Called again inside a started transfer(e.g. by a helper), it sends
+ * a repeated start, and only the outermost yiic_master_trans_stop()
+ * sends the stop. The direction after a nested transfer is the one it
+ * started with, so the outer one starts again to change it.
+ *
+ * 転送を開始して、呼び出したタスクのためにバスを取得します
+ * 開始済みの転送の中で（例：ヘルパーから）再び呼び出すとリピートスタートを送り、
+ * 一番外側のyiic_master_trans_stop()のみストップを送ります
+ * ネストした転送の後の方向はそれが開始した方向ですので、変えるには外側が再び開始します
+ */
 int yiic_master_trans_start(enum yiic_master_tr tran_type);
+
+/*
+ * Same as yiic_master_trans_start(), but give up and return YIIC_RET_TIMEOUT
+ * if the bus cannot be got within timeout_ms(-1 on other errors).
+ * yiic_master_trans_stop() must not be called then.
+ *
+ * yiic_master_trans_start()と同じですが、timeout_ms以内にバスを取得できない場合、
+ * 諦めてYIIC_RET_TIMEOUTを戻ります（その他のエラーは-1）
+ * その場合yiic_master_trans_stop()を呼び出してはいけません
+ */
+int yiic_master_trans_start_timeout(enum yiic_master_tr tran_type, uint16_t timeout_ms);
 int yiic_master_trans_stop(void);
 int yiic_master_select_slave(uint8_t addr);
 uint16_t yiic_master_transmit_data(void *data, uint16_t data_len);
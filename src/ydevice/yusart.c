@@ -7,192 +7,1300 @@
 
 #include <libopencm3/cm3/cortex.h>
 #include <libopencm3/cm3/nvic.h>
+#include <libopencm3/stm32/dma.h>
 #include <libopencm3/stm32/gpio.h>
 #include <libopencm3/stm32/rcc.h>
 #include <libopencm3/stm32/usart.h>
 #include <stdio.h>
+#include <string.h>
 #include "yusart.h"
+#include "../yos/yos_core.h"
+#include "../yos/ybitband.h"
 #include "../../lib/ringbuf/yringbuffer.h"
 
-#define DEFAULT_USART_PORT					USART1
-#define DEFAULT_USART_RCC					RCC_USART1
-#define DEFAULT_USART_GPIO_RCC				RCC_GPIOA
-#define DEFAULT_USART_GPIO_BANK_TX			GPIO_BANK_USART1_TX
-#define DEFAULT_USART_GPIO_BANK_RX			GPIO_BANK_USART1_RX
-#define DEFAULT_USART_GPIO_TX				GPIO_USART1_TX
-#define DEFAULT_USART_GPIO_RX				GPIO_USART1_RX
-#define DEFAULT_USART_NVIC_IRQ				NVIC_USART1_IRQ
+#define YUSART_DMA							DMA1
+#define YUSART_DMA_RCC						RCC_DMA1
 
-static char _yusart_receive_buffer[YUSART_RECEIVE_BUFFER_SIZE_BYTE];
-static struct YRingBuffer _yusart_rx_rb;
+/*
+ * 1 if any enabled USART transmits by DMA, so that the TX DMA interrupt
+ * handler is needed
+ *
+ * 有効なUSARTのどれかがDMAで送信し、TX DMA割り込みハンドラーが必要な場合1
+ */
+#if ((YUSART_ENABLE_USART1 == 1 && YUSART_USART1_TX_DMA == 1)			\
+	|| (YUSART_ENABLE_USART2 == 1 && YUSART_USART2_TX_DMA == 1)		\
+	|| (YUSART_ENABLE_USART3 == 1 && YUSART_USART3_TX_DMA == 1))
+#define _YUSART_ANY_TX_DMA					1
+#else
+#define _YUSART_ANY_TX_DMA					0
+#endif
+
+/*
+ * One driver instance per USART
+ *
+ * USARTごとのドライバーのインスタンス
+ */
+struct yusart {
+	/*
+	 * Hardware of the USART, fixed
+	 *
+	 * USARTのハードウェア、固定です
+	 */
+	uint32_t port;
+	enum rcc_periph_clken rcc;
+	enum rcc_periph_clken gpio_rcc;
+	uint32_t gpio_bank;
+	uint16_t gpio_tx;
+	uint16_t gpio_rx;
+	uint16_t gpio_cts;
+	uint16_t gpio_rts;
+	uint8_t nvic_irq;
+	uint8_t tx_dma_channel;
+	uint8_t tx_dma_nvic_irq;
+	uint8_t rx_dma_channel;
+	uint8_t rx_dma_nvic_irq;
+	uint8_t tx_dma;
+
+	uint32_t baudrate;
+	uint8_t is_inited;
+	uint8_t flow_control;
+
+	/*
+	 * Non-zero while the sender is told to stop
+	 *
+	 * 送信側に止まるように伝えている間は0以外です
+	 */
+	uint8_t rx_paused;
+
+	struct yusart_stats stats;
+
+	char receive_buffer[YUSART_RECEIVE_BUFFER_SIZE_BYTE];
+	struct YRingBuffer rx_rb;
+
+	/*
+	 * Circular receive
+	 *
+	 * DMA keeps writing received bytes into rx_dma_buffer round and round.
+	 * On the half/full transfer events and when the line becomes idle,
+	 * the bytes from rx_dma_pos up to where DMA is now are moved
+	 * to rx_rb at once.
+	 *
+	 * 循環受信
+	 *
+	 * DMAは受信したバイトをrx_dma_bufferにぐるぐると書き込み続けます
+	 * 半分／全部の転送イベントとラインがアイドルになった時、
+	 * rx_dma_posからDMAの現在位置までのバイトをまとめてrx_rbに移します
+	 */
+	uint8_t rx_dma_buffer[YUSART_RX_DMA_BUFFER_SIZE_BYTE];
+	uint16_t rx_dma_pos;
+
+	/*
+	 * Number of BASIC_IO_TEXT_END_MARK in rx_rb
+	 *
+	 * rx_rbの中のBASIC_IO_TEXT_END_MARKの数
+	 */
+	volatile uint16_t rx_text_end_count;
+
+	/*
+	 * Bit [task id] is set while the task is waiting for any byte/a text end
+	 *
+	 * 何かのバイト／テキスト終端を待っているタスクのビット[タスクid]がセットされます
+	 */
+	volatile uint32_t rx_waiters;
+	volatile uint32_t rx_line_waiters;
+
+	/*
+	 * Double-buffered transmit
+	 *
+	 * Writers append to tx_buffer[tx_fill], and DMA sends the other one.
+	 * When DMA finishes, the filled one is handed to DMA and writers move
+	 * to the one just sent. So a writer only has to wait when the buffer
+	 * being filled is full while DMA is still busy.
+	 *
+	 * ダブルバッファの送信
+	 *
+	 * 書き込みはtx_buffer[tx_fill]に追加し、DMAはもう一方を送信します
+	 * DMAが終わったら、溜まった方をDMAに渡して、書き込みは送信済みの方に移ります
+	 * そのため、書き込みが待つのはDMAが動いている間に溜めている方が満杯になった時のみです
+	 */
+	uint8_t tx_buffer[2][YUSART_TRANSMIT_BUFFER_SIZE_BYTE];
+	volatile uint16_t tx_len[2];
+	volatile uint8_t tx_fill;
+	volatile uint8_t tx_dma_busy;
+	uint32_t tx_dma_addr;
+	uint16_t tx_dma_len;
+
+	/*
+	 * XON/XOFF to be sent ahead of the output(0 if none).
+	 * The running DMA is paused(tx_dma_paused) until it goes out.
+	 *
+	 * 出力より先に送信するXON/XOFF（ない場合0）
+	 * それが出ていくまで動いているDMAは一時停止します（tx_dma_paused）
+	 */
+	volatile uint8_t tx_ctrl_char;
+	uint8_t tx_dma_paused;
+
+	/*
+	 * Ring buffer over tx_buffer, used instead when not transmitting by DMA.
+	 * The TXE interrupt takes bytes out of it one by one.
+	 *
+	 * DMAで送信しない場合に代わりに使う、tx_bufferを領域とするリングバッファ
+	 * TXE割り込みで一バイトずつ取り出します
+	 */
+	struct YRingBuffer tx_rb;
+
+	/*
+	 * Bit [task id] is set while the task is waiting for room to write
+	 *
+	 * 書き込む余地を待っているタスクのビット[タスクid]がセットされます
+	 */
+	volatile uint32_t tx_waiters;
+};
+
+static void _yusart_isr(struct yusart *u);
+#if (_YUSART_ANY_TX_DMA == 1)
+static void _yusart_tx_dma_isr(struct yusart *u);
+#endif
+static void _yusart_rx_dma_isr(struct yusart *u);
+
+#if (YUSART_ENABLE_USART1 == 1)
+static struct yusart _yusart1 = {
+	.port = USART1,
+	.rcc = RCC_USART1,
+	.gpio_rcc = RCC_GPIOA,
+	.gpio_bank = GPIO_BANK_USART1_TX,
+	.gpio_tx = GPIO_USART1_TX,
+	.gpio_rx = GPIO_USART1_RX,
+	.gpio_cts = GPIO_USART1_CTS,
+	.gpio_rts = GPIO_USART1_RTS,
+	.nvic_irq = NVIC_USART1_IRQ,
+	.tx_dma_channel = DMA_CHANNEL4,
+	.tx_dma_nvic_irq = NVIC_DMA1_CHANNEL4_IRQ,
+	.rx_dma_channel = DMA_CHANNEL5,
+	.rx_dma_nvic_irq = NVIC_DMA1_CHANNEL5_IRQ,
+	.tx_dma = YUSART_USART1_TX_DMA
+};
 
-static void yusart_interrupt_disable(void)
+void usart1_isr(void)
+{
+	_yusart_isr(&_yusart1);
+}
+
+#if (YUSART_USART1_TX_DMA == 1)
+void dma1_channel4_isr(void)
+{
+	_yusart_tx_dma_isr(&_yusart1);
+}
+#endif
+
+void dma1_channel5_isr(void)
 {
-	usart_disable_rx_interrupt(DEFAULT_USART_PORT);
-	//usart_disable_tx_interrupt(DEFAULT_USART_PORT);
-	//usart_disable_tx_complete_interrupt(DEFAULT_USART_PORT);
-	//usart_disable_idle_interrupt(DEFAULT_USART_PORT);
-	//usart_disable_error_interrupt(DEFAULT_USART_PORT);
+	_yusart_rx_dma_isr(&_yusart1);
 }
+#endif
 
-static void yusart_interrupt_enable(void)
+#if (YUSART_ENABLE_USART2 == 1)
+static struct yusart _yusart2 = {
+	.port = USART2,
+	.rcc = RCC_USART2,
+	.gpio_rcc = RCC_GPIOA,
+	.gpio_bank = GPIO_BANK_USART2_TX,
+	.gpio_tx = GPIO_USART2_TX,
+	.gpio_rx = GPIO_USART2_RX,
+	.gpio_cts = GPIO_USART2_CTS,
+	.gpio_rts = GPIO_USART2_RTS,
+	.nvic_irq = NVIC_USART2_IRQ,
+	.tx_dma_channel = DMA_CHANNEL7,
+	.tx_dma_nvic_irq = NVIC_DMA1_CHANNEL7_IRQ,
+	.rx_dma_channel = DMA_CHANNEL6,
+	.rx_dma_nvic_irq = NVIC_DMA1_CHANNEL6_IRQ,
+	.tx_dma = YUSART_USART2_TX_DMA
+};
+
+void usart2_isr(void)
 {
-	usart_enable_rx_interrupt(DEFAULT_USART_PORT);
-	//usart_enable_tx_interrupt(DEFAULT_USART_PORT);
-	//usart_enable_tx_complete_interrupt(DEFAULT_USART_PORT);
-	//usart_enable_idle_interrupt(DEFAULT_USART_PORT);
-	//usart_enable_error_interrupt(DEFAULT_USART_PORT);
+	_yusart_isr(&_yusart2);
 }
 
-static void yusart_init(uint32_t baudrate, uint8_t stop_bits)
+#if (YUSART_USART2_TX_DMA == 1)
+void dma1_channel7_isr(void)
 {
+	_yusart_tx_dma_isr(&_yusart2);
+}
+#endif
+
+void dma1_channel6_isr(void)
+{
+	_yusart_rx_dma_isr(&_yusart2);
+}
+#endif
+
+#if (YUSART_ENABLE_USART3 == 1)
+static struct yusart _yusart3 = {
+	.port = USART3,
+	.rcc = RCC_USART3,
+	.gpio_rcc = RCC_GPIOB,
+	.gpio_bank = GPIO_BANK_USART3_TX,
+	.gpio_tx = GPIO_USART3_TX,
+	.gpio_rx = GPIO_USART3_RX,
+	.gpio_cts = GPIO_USART3_CTS,
+	.gpio_rts = GPIO_USART3_RTS,
+	.nvic_irq = NVIC_USART3_IRQ,
+	.tx_dma_channel = DMA_CHANNEL2,
+	.tx_dma_nvic_irq = NVIC_DMA1_CHANNEL2_IRQ,
+	.rx_dma_channel = DMA_CHANNEL3,
+	.rx_dma_nvic_irq = NVIC_DMA1_CHANNEL3_IRQ,
+	.tx_dma = YUSART_USART3_TX_DMA
+};
+
+void usart3_isr(void)
+{
+	_yusart_isr(&_yusart3);
+}
+
+#if (YUSART_USART3_TX_DMA == 1)
+void dma1_channel2_isr(void)
+{
+	_yusart_tx_dma_isr(&_yusart3);
+}
+#endif
+
+void dma1_channel3_isr(void)
+{
+	_yusart_rx_dma_isr(&_yusart3);
+}
+#endif
+
+static struct yusart *_yusart_instance(uint8_t usart_no)
+{
+	struct yusart *u = NULL;
+
+	switch (usart_no) {
+#if (YUSART_ENABLE_USART1 == 1)
+	case 1:
+		u = &_yusart1;
+		break;
+#endif
+#if (YUSART_ENABLE_USART2 == 1)
+	case 2:
+		u = &_yusart2;
+		break;
+#endif
+#if (YUSART_ENABLE_USART3 == 1)
+	case 3:
+		u = &_yusart3;
+		break;
+#endif
+	default:
+		break;
+	}
+
+	return u;
+}
+
+void *yusart_io_context(uint8_t usart_no, uint32_t baudrate)
+{
+	struct yusart *u = _yusart_instance(usart_no);
+	if (u != NULL) {
+		u->baudrate = baudrate;
+	}
+
+	return u;
+}
+
+static uint32_t _yusart_max_baudrate(struct yusart *u)
+{
+	uint32_t max_baudrate = ((u->port == USART1) ? rcc_apb2_frequency : rcc_apb1_frequency) / 16;
+
+	/*
+	 * Half of the DMA receive buffer(10 bits a byte) must last
+	 * YUSART_RX_MAX_LATENCY_US
+	 *
+	 * DMA受信バッファの半分（1バイト10ビット）がYUSART_RX_MAX_LATENCY_USの間持つ必要があります
+	 */
+	uint32_t rx_max_baudrate = (uint32_t)((uint64_t)(YUSART_RX_DMA_BUFFER_SIZE_BYTE / 2)
+									* 10 * 1000000 / YUSART_RX_MAX_LATENCY_US);
+	if (max_baudrate > rx_max_baudrate) {
+		max_baudrate = rx_max_baudrate;
+	}
+
+	return max_baudrate;
+}
+
+int yusart_get_stats(uint8_t usart_no, struct yusart_stats *stats)
+{
+	struct yusart *u = _yusart_instance(usart_no);
+	if (u == NULL || !u->is_inited || stats == NULL) {
+		return -1;
+	}
+
+	uint32_t primask = cm_mask_interrupts(1);
+	*stats = u->stats;
+	cm_mask_interrupts(primask);
+
+	return 0;
+}
+
+/*
+ * Return non-zero if there is nothing left to send and the last byte
+ * has left the line. TC can be trusted here, as every path writing DR
+ * clears it(see _yusart_tx_dma_start_irq()).
+ *
+ * 送信するものが残っておらず、最後のバイトがラインから出た場合0以外を戻ります
+ * DRに書き込むすべての経路がTCをクリアしますので（_yusart_tx_dma_start_irq()を参照）、
+ * ここではTCを信頼できます
+ */
+static int _yusart_tx_is_idle(struct yusart *u)
+{
+	int idle;
+
+	uint32_t primask = cm_mask_interrupts(1);
+	if (u->tx_dma) {
+		idle = !u->tx_dma_busy && u->tx_len[u->tx_fill] == 0;
+	} else {
+		idle = YRingBufferGetCurrentLen(&(u->tx_rb)) == 0;
+	}
+	idle = idle && u->tx_ctrl_char == 0 && usart_get_flag(u->port, USART_SR_TC);
+	cm_mask_interrupts(primask);
+
+	return idle;
+}
+
+/*
+ * Return non-zero if at least one more byte can be queued.
+ * Must be called with interrupts disabled.
+ *
+ * 少なくとも一バイトをさらに溜められる場合0以外を戻ります
+ * 割り込み禁止の状態で呼び出す必要があります
+ */
+static int _yusart_tx_has_room_irq(struct yusart *u)
+{
+	if (u->tx_dma) {
+		return u->tx_len[u->tx_fill] < YUSART_TRANSMIT_BUFFER_SIZE_BYTE;
+	}
+
+	return YRingBufferGetCurrentLen(&(u->tx_rb)) < YRingBufferGetSize(&(u->tx_rb));
+}
+
+int yusart_set_baudrate(uint8_t usart_no, uint32_t baudrate)
+{
+	struct yusart *u = _yusart_instance(usart_no);
+	if (u == NULL || baudrate < YUSART_MIN_BAUDRATE || baudrate > _yusart_max_baudrate(u)) {
+		return -1;
+	}
+
+	if (!u->is_inited) {
+		u->baudrate = baudrate;
+		return 0;
+	}
+
+	/*
+	 * Let what is being sent go out at the old baudrate
+	 *
+	 * 送信中のデータは古いボーレートで出させます
+	 */
+	while (!_yusart_tx_is_idle(u)) {
+		if (yos_is_started()) {
+			yos_task_msleep(1);
+		}
+	}
+
 	cm_disable_interrupts();
+	usart_disable(u->port);
+	usart_set_baudrate(u->port, baudrate);
+	u->baudrate = baudrate;
+	usart_enable(u->port);
+	cm_enable_interrupts();
+
+	return 0;
+}
+
+uint32_t yusart_get_baudrate(uint8_t usart_no)
+{
+	struct yusart *u = _yusart_instance(usart_no);
+	if (u == NULL) {
+		return 0;
+	}
+
+	return u->baudrate;
+}
+
+/*
+ * Start DMA for tx_dma_addr/tx_dma_len.
+ * TC is cleared first, as writes by DMA do not clear it and it would
+ * still tell the line is idle from the last transfer.
+ * Must be called with interrupts disabled.
+ *
+ * tx_dma_addr／tx_dma_lenのDMAを開始します
+ * DMAによる書き込みはTCをクリアせず、前回の転送からラインが空いていると
+ * 示したままになるので、先にTCをクリアします
+ * 割り込み禁止の状態で呼び出す必要があります
+ */
+static void _yusart_tx_dma_start_irq(struct yusart *u)
+{
+	/*
+	 * TC is rc_w0, writing 1 to the other bits has no effect
+	 *
+	 * TCはrc_w0ですので、他のビットに1を書き込んでも影響はありません
+	 */
+	USART_SR(u->port) = ~USART_SR_TC;
+
+	dma_set_memory_address(YUSART_DMA, u->tx_dma_channel, u->tx_dma_addr);
+	dma_set_number_of_data(YUSART_DMA, u->tx_dma_channel, u->tx_dma_len);
+	dma_enable_channel(YUSART_DMA, u->tx_dma_channel);
+}
+
+/*
+ * Hand the filled buffer to DMA if DMA is idle.
+ * Must be called with interrupts disabled.
+ *
+ * DMAが空いている場合、溜まったバッファをDMAに渡します
+ * 割り込み禁止の状態で呼び出す必要があります
+ */
+static void _yusart_tx_kick_irq(struct yusart *u)
+{
+	uint8_t fill = u->tx_fill;
+	if (u->tx_dma_busy || u->tx_ctrl_char != 0 || u->tx_len[fill] == 0) {
+		return;
+	}
+
+	u->tx_dma_addr = (uint32_t)(u->tx_buffer[fill]);
+	u->tx_dma_len = u->tx_len[fill];
+	dma_disable_channel(YUSART_DMA, u->tx_dma_channel);
+	_yusart_tx_dma_start_irq(u);
+	u->tx_dma_busy = 1;
+
+	fill ^= 1;
+	u->tx_len[fill] = 0;
+	u->tx_fill = fill;
+}
+
+/*
+ * Send ch(XON/XOFF) ahead of the pending output. The running DMA is
+ * paused, and the TXE interrupt sends ch once DR is empty, right after
+ * the byte already handed to the USART.
+ * Must be called with interrupts disabled.
+ *
+ * ch（XON/XOFF）を溜まっている出力より先に送信します。動いているDMAは一時停止して、
+ * USARTに渡し済みのバイトの直後、DRが空いたらTXE割り込みでchを送信します
+ * 割り込み禁止の状態で呼び出す必要があります
+ */
+static void _yusart_tx_send_ctrl_irq(struct yusart *u, uint8_t ch)
+{
+	uint16_t remaining;
+
+	u->tx_ctrl_char = ch;
+	if (!u->tx_dma) {
+		/*
+		 * The TXE interrupt sends it before the next byte from the ring
+		 *
+		 * TXE割り込みがリングの次のバイトの前に送信します
+		 */
+		usart_enable_tx_interrupt(u->port);
+		return;
+	}
 
-	rcc_periph_clock_enable(DEFAULT_USART_GPIO_RCC);
-	rcc_periph_clock_enable(DEFAULT_USART_RCC);
+	if (u->tx_dma_busy && !u->tx_dma_paused) {
+		dma_disable_channel(YUSART_DMA, u->tx_dma_channel);
+		remaining = dma_get_number_of_data(YUSART_DMA, u->tx_dma_channel);
+		if (remaining == 0) {
+			/*
+			 * Already done, the DMA interrupt has nothing left to do
+			 *
+			 * すでに終わりました、DMA割り込みがやることは残っていません
+			 */
+			dma_clear_interrupt_flags(YUSART_DMA, u->tx_dma_channel, DMA_TCIF);
+			u->tx_dma_busy = 0;
+			yos_task_wake_waiters_irq(&(u->tx_waiters));
+		} else {
+			u->tx_dma_addr += u->tx_dma_len - remaining;
+			u->tx_dma_len = remaining;
+			u->tx_dma_paused = 1;
+		}
+	}
+
+	usart_enable_tx_interrupt(u->port);
+}
+
+/*
+ * Called from the USART interrupt when DR is empty
+ *
+ * DRが空いた時にUSART割り込みから呼び出されます
+ */
+static void _yusart_tx_ctrl_done_irq(struct yusart *u)
+{
+	usart_send(u->port, u->tx_ctrl_char);
+	u->tx_ctrl_char = 0;
+	usart_disable_tx_interrupt(u->port);
+
+	if (u->tx_dma_paused) {
+		u->tx_dma_paused = 0;
+		_yusart_tx_dma_start_irq(u);
+	} else {
+		_yusart_tx_kick_irq(u);
+	}
+}
+
+/*
+ * Tell the sender to stop/restart by the receive buffer watermarks.
+ * Must be called with interrupts disabled.
+ *
+ * 受信バッファの上限／下限により送信側に止まる／再開するように伝えます
+ * 割り込み禁止の状態で呼び出す必要があります
+ */
+static void _yusart_rx_flow_control_irq(struct yusart *u)
+{
+	if (u->flow_control == YUSART_FLOW_CONTROL_NONE) {
+		return;
+	}
+
+	unsigned long len = YRingBufferGetCurrentLen(&(u->rx_rb));
+	if (!u->rx_paused && len >= YUSART_RX_HIGH_WATERMARK) {
+		u->rx_paused = 1;
+		u->stats.rx_pauses++;
+		if (u->flow_control == YUSART_FLOW_CONTROL_RTS_CTS) {
+			gpio_set(u->gpio_bank, u->gpio_rts);
+		} else {
+			_yusart_tx_send_ctrl_irq(u, YUSART_XOFF);
+		}
+	} else if (u->rx_paused && len <= YUSART_RX_LOW_WATERMARK) {
+		u->rx_paused = 0;
+		if (u->flow_control == YUSART_FLOW_CONTROL_RTS_CTS) {
+			gpio_clear(u->gpio_bank, u->gpio_rts);
+		} else {
+			_yusart_tx_send_ctrl_irq(u, YUSART_XON);
+		}
+	}
+}
 
-	YRingBufferInit(&_yusart_rx_rb, _yusart_receive_buffer, sizeof(_yusart_receive_buffer));
+/*
+ * Set the pins and the USART for u->flow_control.
+ * Must be called with interrupts disabled.
+ *
+ * u->flow_controlに合わせてピンとUSARTを設定します
+ * 割り込み禁止の状態で呼び出す必要があります
+ */
+static void _yusart_flow_control_setup_irq(struct yusart *u)
+{
+	u->rx_paused = 0;
+
+	if (u->flow_control == YUSART_FLOW_CONTROL_RTS_CTS) {
+		/*
+		 * RTS is driven by software(low means ready), CTS by hardware
+		 *
+		 * RTSはソフトウェアで（ローは受信可能）、CTSはハードウェアで扱います
+		 */
+		gpio_clear(u->gpio_bank, u->gpio_rts);
+		gpio_set_mode(u->gpio_bank, GPIO_MODE_OUTPUT_50_MHZ,
+					GPIO_CNF_OUTPUT_PUSHPULL, u->gpio_rts);
+		gpio_set_mode(u->gpio_bank, GPIO_MODE_INPUT,
+					GPIO_CNF_INPUT_FLOAT, u->gpio_cts);
+		usart_set_flow_control(u->port, USART_FLOWCONTROL_CTS);
+	} else {
+		usart_set_flow_control(u->port, USART_FLOWCONTROL_NONE);
+		if (u->flow_control == YUSART_FLOW_CONTROL_XON_XOFF) {
+			/*
+			 * The sender might have been stopped before
+			 *
+			 * 送信側は以前に止められたかもしれません
+			 */
+			_yusart_tx_send_ctrl_irq(u, YUSART_XON);
+		}
+	}
+
+	_yusart_rx_flow_control_irq(u);
+}
 
-	gpio_set_mode(DEFAULT_USART_GPIO_BANK_TX, GPIO_MODE_OUTPUT_50_MHZ,
-				GPIO_CNF_OUTPUT_ALTFN_PUSHPULL, DEFAULT_USART_GPIO_TX);
-	gpio_set_mode(DEFAULT_USART_GPIO_BANK_RX, GPIO_MODE_INPUT,
-				GPIO_CNF_INPUT_FLOAT, DEFAULT_USART_GPIO_RX);
+int yusart_set_flow_control(uint8_t usart_no, uint8_t flow_control)
+{
+	struct yusart *u = _yusart_instance(usart_no);
+	if (u == NULL || flow_control > YUSART_FLOW_CONTROL_XON_XOFF) {
+		return -1;
+	}
+
+	uint32_t primask = cm_mask_interrupts(1);
+	u->flow_control = flow_control;
+	if (u->is_inited) {
+		_yusart_flow_control_setup_irq(u);
+	}
+	cm_mask_interrupts(primask);
+
+	return 0;
+}
+
+uint8_t yusart_get_flow_control(uint8_t usart_no)
+{
+	struct yusart *u = _yusart_instance(usart_no);
+	if (u == NULL) {
+		return YUSART_FLOW_CONTROL_NONE;
+	}
+
+	return u->flow_control;
+}
+
+static void _yusart_tx_irq_init(struct yusart *u)
+{
+	YRingBufferInit(&(u->tx_rb), u->tx_buffer, sizeof(u->tx_buffer));
+	u->tx_ctrl_char = 0;
+	u->tx_waiters = 0;
+}
+
+static void _yusart_tx_irq_deinit(struct yusart *u)
+{
+	usart_disable_tx_interrupt(u->port);
+	YRingBufferDestory(&(u->tx_rb));
+	u->tx_ctrl_char = 0;
+}
+
+/*
+ * Called from the USART interrupt when DR is empty
+ *
+ * DRが空いた時にUSART割り込みから呼び出されます
+ */
+static void _yusart_tx_irq_isr(struct yusart *u)
+{
+	uint8_t b;
+	if (u->tx_ctrl_char != 0) {
+		usart_send(u->port, u->tx_ctrl_char);
+		u->tx_ctrl_char = 0;
+	} else if (YRingBufferGetData(&(u->tx_rb), &b, sizeof(b)) == sizeof(b)) {
+		usart_send(u->port, b);
+	}
+
+	unsigned long len = YRingBufferGetCurrentLen(&(u->tx_rb));
+	if (len == 0 && u->tx_ctrl_char == 0) {
+		usart_disable_tx_interrupt(u->port);
+	}
+
+	/*
+	 * Wake writers only when half of the ring is free,
+	 * not for every byte
+	 *
+	 * 書き込みを起こすのはリングの半分が空いた時のみです、一バイトごとではありません
+	 */
+	if (u->tx_waiters != 0 && len <= YRingBufferGetSize(&(u->tx_rb)) / 2) {
+		yos_task_wake_waiters_irq(&(u->tx_waiters));
+	}
+}
+
+static void _yusart_tx_dma_init(struct yusart *u)
+{
+	u->tx_len[0] = u->tx_len[1] = 0;
+	u->tx_fill = 0;
+	u->tx_dma_busy = 0;
+	u->tx_ctrl_char = 0;
+	u->tx_dma_paused = 0;
+	u->tx_waiters = 0;
+
+	rcc_periph_clock_enable(YUSART_DMA_RCC);
+	dma_channel_reset(YUSART_DMA, u->tx_dma_channel);
+	dma_set_peripheral_address(YUSART_DMA, u->tx_dma_channel, (uint32_t)&USART_DR(u->port));
+	dma_set_read_from_memory(YUSART_DMA, u->tx_dma_channel);
+	dma_enable_memory_increment_mode(YUSART_DMA, u->tx_dma_channel);
+	dma_set_peripheral_size(YUSART_DMA, u->tx_dma_channel, DMA_CCR_PSIZE_8BIT);
+	dma_set_memory_size(YUSART_DMA, u->tx_dma_channel, DMA_CCR_MSIZE_8BIT);
+	dma_set_priority(YUSART_DMA, u->tx_dma_channel, DMA_CCR_PL_LOW);
+	dma_enable_transfer_complete_interrupt(YUSART_DMA, u->tx_dma_channel);
+	nvic_enable_irq(u->tx_dma_nvic_irq);
+
+	usart_enable_tx_dma(u->port);
+}
+
+static void _yusart_tx_dma_deinit(struct yusart *u)
+{
+	usart_disable_tx_dma(u->port);
+	nvic_disable_irq(u->tx_dma_nvic_irq);
+	dma_disable_channel(YUSART_DMA, u->tx_dma_channel);
+	usart_disable_tx_interrupt(u->port);
+	u->tx_dma_busy = 0;
+	u->tx_ctrl_char = 0;
+	u->tx_dma_paused = 0;
+}
+
+#if (_YUSART_ANY_TX_DMA == 1)
+static void _yusart_tx_dma_isr(struct yusart *u)
+{
+	if (dma_get_interrupt_flag(YUSART_DMA, u->tx_dma_channel, DMA_TCIF)) {
+		dma_clear_interrupt_flags(YUSART_DMA, u->tx_dma_channel, DMA_TCIF);
+		dma_disable_channel(YUSART_DMA, u->tx_dma_channel);
+		u->tx_dma_busy = 0;
+		_yusart_tx_kick_irq(u);
+		yos_task_wake_waiters_irq(&(u->tx_waiters));
+	}
+}
+#endif
+
+/*
+ * Move newly received bytes from the DMA buffer to the ring buffer.
+ * Must be called with interrupts disabled.
+ *
+ * 新しく受信したバイトをDMAバッファからリングバッファに移します
+ * 割り込み禁止の状態で呼び出す必要があります
+ */
+static void _yusart_rx_dma_put_irq(struct yusart *u, uint8_t *data, uint16_t len)
+{
+	unsigned long room = YRingBufferGetSize(&(u->rx_rb)) - YRingBufferGetCurrentLen(&(u->rx_rb));
+	if (len > room) {
+		/*
+		 * The oldest bytes are overwritten
+		 *
+		 * 最も古いバイトが上書きされます
+		 */
+		u->stats.rx_dropped += len - room;
+	}
+	u->stats.rx_bytes += len;
+
+	uint16_t i = 0;
+	while (i < len) {
+		if (data[i] == BASIC_IO_TEXT_END_MARK) {
+			u->rx_text_end_count++;
+		}
+
+		i++;
+	}
+
+	YRingBufferPutData(&(u->rx_rb), data, len, 1);
+}
+
+static void _yusart_rx_dma_drain_irq(struct yusart *u)
+{
+	uint16_t pos = YUSART_RX_DMA_BUFFER_SIZE_BYTE -
+					dma_get_number_of_data(YUSART_DMA, u->rx_dma_channel);
+	if (pos >= YUSART_RX_DMA_BUFFER_SIZE_BYTE) {
+		pos = 0;
+	}
+
+	if (pos == u->rx_dma_pos) {
+		return;
+	}
+
+	uint16_t text_end_count = u->rx_text_end_count;
+	if (pos > u->rx_dma_pos) {
+		_yusart_rx_dma_put_irq(u, u->rx_dma_buffer + u->rx_dma_pos, pos - u->rx_dma_pos);
+	} else {
+		/*
+		 * DMA has wrapped around
+		 *
+		 * DMAは一周しました
+		 */
+		_yusart_rx_dma_put_irq(u, u->rx_dma_buffer + u->rx_dma_pos,
+								YUSART_RX_DMA_BUFFER_SIZE_BYTE - u->rx_dma_pos);
+		if (pos > 0) {
+			_yusart_rx_dma_put_irq(u, u->rx_dma_buffer, pos);
+		}
+	}
+	u->rx_dma_pos = pos;
+	_yusart_rx_flow_control_irq(u);
+
+	yos_task_wake_waiters_irq(&(u->rx_waiters));
+	if (u->rx_text_end_count != text_end_count
+		|| YRingBufferGetCurrentLen(&(u->rx_rb)) == YRingBufferGetSize(&(u->rx_rb))) {
+		yos_task_wake_waiters_irq(&(u->rx_line_waiters));
+	}
+}
+
+static void _yusart_rx_dma_init(struct yusart *u)
+{
+	u->rx_dma_pos = 0;
+	u->rx_text_end_count = 0;
+	u->rx_waiters = 0;
+	u->rx_line_waiters = 0;
+
+	rcc_periph_clock_enable(YUSART_DMA_RCC);
+	dma_channel_reset(YUSART_DMA, u->rx_dma_channel);
+	dma_set_peripheral_address(YUSART_DMA, u->rx_dma_channel, (uint32_t)&USART_DR(u->port));
+	dma_set_memory_address(YUSART_DMA, u->rx_dma_channel, (uint32_t)(u->rx_dma_buffer));
+	dma_set_number_of_data(YUSART_DMA, u->rx_dma_channel, YUSART_RX_DMA_BUFFER_SIZE_BYTE);
+	dma_set_read_from_peripheral(YUSART_DMA, u->rx_dma_channel);
+	dma_enable_memory_increment_mode(YUSART_DMA, u->rx_dma_channel);
+	dma_enable_circular_mode(YUSART_DMA, u->rx_dma_channel);
+	dma_set_peripheral_size(YUSART_DMA, u->rx_dma_channel, DMA_CCR_PSIZE_8BIT);
+	dma_set_memory_size(YUSART_DMA, u->rx_dma_channel, DMA_CCR_MSIZE_8BIT);
+	/*
+	 * Receiving cannot wait, so it goes before transmitting
+	 *
+	 * 受信は待てないため、送信より優先します
+	 */
+	dma_set_priority(YUSART_DMA, u->rx_dma_channel, DMA_CCR_PL_HIGH);
+	dma_enable_half_transfer_interrupt(YUSART_DMA, u->rx_dma_channel);
+	dma_enable_transfer_complete_interrupt(YUSART_DMA, u->rx_dma_channel);
+	nvic_enable_irq(u->rx_dma_nvic_irq);
+	dma_enable_channel(YUSART_DMA, u->rx_dma_channel);
+
+	usart_enable_rx_dma(u->port);
+}
+
+static void _yusart_rx_dma_deinit(struct yusart *u)
+{
+	usart_disable_rx_dma(u->port);
+	nvic_disable_irq(u->rx_dma_nvic_irq);
+	dma_disable_channel(YUSART_DMA, u->rx_dma_channel);
+}
+
+static void _yusart_rx_dma_isr(struct yusart *u)
+{
+	if (dma_get_interrupt_flag(YUSART_DMA, u->rx_dma_channel, DMA_HTIF | DMA_TCIF)) {
+		dma_clear_interrupt_flags(YUSART_DMA, u->rx_dma_channel, DMA_HTIF | DMA_TCIF);
+		_yusart_rx_dma_drain_irq(u);
+	}
+}
+
+static void yusart_interrupt_disable(struct yusart *u)
+{
+	//usart_disable_rx_interrupt(u->port);
+	//usart_disable_tx_interrupt(u->port);
+	//usart_disable_tx_complete_interrupt(u->port);
+	usart_disable_idle_interrupt(u->port);
+	usart_disable_error_interrupt(u->port);
+}
+
+static void yusart_interrupt_enable(struct yusart *u)
+{
+	//usart_enable_rx_interrupt(u->port);
+	//usart_enable_tx_interrupt(u->port);
+	//usart_enable_tx_complete_interrupt(u->port);
+	usart_enable_idle_interrupt(u->port);
+	usart_enable_error_interrupt(u->port);
+}
+
+static void yusart_init(struct yusart *u, uint32_t baudrate, uint8_t stop_bits)
+{
+	cm_disable_interrupts();
+
+	rcc_periph_clock_enable(u->gpio_rcc);
+	rcc_periph_clock_enable(u->rcc);
+
+	YRingBufferInit(&(u->rx_rb), u->receive_buffer, sizeof(u->receive_buffer));
+	memset(&(u->stats), 0, sizeof(u->stats));
+
+	gpio_set_mode(u->gpio_bank, GPIO_MODE_OUTPUT_50_MHZ,
+				GPIO_CNF_OUTPUT_ALTFN_PUSHPULL, u->gpio_tx);
+	gpio_set_mode(u->gpio_bank, GPIO_MODE_INPUT,
+				GPIO_CNF_INPUT_FLOAT, u->gpio_rx);
 
 	/* Setup UART parameters. */
-	usart_set_baudrate(DEFAULT_USART_PORT, baudrate);
-	usart_set_databits(DEFAULT_USART_PORT, USART_DATABIT);
-	usart_set_stopbits(DEFAULT_USART_PORT, USART_STOPBITS_1);
-	usart_set_mode(DEFAULT_USART_PORT, USART_MODE_TX_RX);
-	usart_set_parity(DEFAULT_USART_PORT, USART_PARITY_NONE);
-	usart_set_flow_control(DEFAULT_USART_PORT, USART_FLOWCONTROL_NONE);
+	usart_set_baudrate(u->port, baudrate);
+	usart_set_databits(u->port, USART_DATABIT);
+	usart_set_stopbits(u->port, USART_STOPBITS_1);
+	usart_set_mode(u->port, USART_MODE_TX_RX);
+	usart_set_parity(u->port, USART_PARITY_NONE);
 
-	yusart_interrupt_enable();
-	nvic_enable_irq(DEFAULT_USART_NVIC_IRQ);
+	if (u->tx_dma) {
+		_yusart_tx_dma_init(u);
+	} else {
+		_yusart_tx_irq_init(u);
+	}
+	_yusart_rx_dma_init(u);
+	_yusart_flow_control_setup_irq(u);
+
+	yusart_interrupt_enable(u);
+	nvic_enable_irq(u->nvic_irq);
 
 	/* Finally enable the USART. */
-	usart_enable(DEFAULT_USART_PORT);
+	usart_enable(u->port);
+	u->is_inited = 1;
 
 	cm_enable_interrupts();
 }
 
-void usart1_isr(void)
+static void _yusart_isr(struct yusart *u)
 {
-	char d;
-	if (usart_get_flag(DEFAULT_USART_PORT, USART_SR_RXNE)) {
-		/* Read data register not empty */
-		d = usart_recv(DEFAULT_USART_PORT);
-		YRingBufferPutData(&_yusart_rx_rb, &d, sizeof(d), 1);
-#if 0
-	} else if (usart_get_flag(DEFAULT_USART_PORT, USART_SR_TXE)) {
-		/* Transmit data buffer empty */
-	} else if (usart_get_flag(DEFAULT_USART_PORT, USART_SR_TC)) {
-		/* Transmission complete */
-	} else if (usart_get_flag(DEFAULT_USART_PORT, USART_SR_ORE)) {
-		/* Overrun error */
-		usart_recv(DEFAULT_USART_PORT);
-	} else if (usart_get_flag(DEFAULT_USART_PORT, USART_SR_NE)) {
-		/* Noise error */
-		usart_recv(DEFAULT_USART_PORT);
-	} else if (usart_get_flag(DEFAULT_USART_PORT, USART_SR_FE)) {
-		/* Framing error */
-		usart_recv(DEFAULT_USART_PORT);
-	} else if (usart_get_flag(DEFAULT_USART_PORT, USART_SR_PE)) {
-		/* Parity error */
-		usart_recv(DEFAULT_USART_PORT);
-#endif
+	uint32_t sr = USART_SR(u->port);
+	if (!u->tx_dma) {
+		if ((sr & USART_SR_TXE) && (USART_CR1(u->port) & USART_CR1_TXEIE)) {
+			_yusart_tx_irq_isr(u);
+		}
+	} else if (u->tx_ctrl_char != 0 && (sr & USART_SR_TXE)
+				&& (USART_CR1(u->port) & USART_CR1_TXEIE)) {
+		_yusart_tx_ctrl_done_irq(u);
 	}
+
+	if ((sr & (USART_SR_IDLE | USART_SR_ORE | USART_SR_NE | USART_SR_FE | USART_SR_PE)) == 0) {
+		return;
+	}
+
+	/*
+	 * Reading SR(above) then DR clears IDLE and the error flags.
+	 * With an overrun, the byte in DR is kept and the new one is lost.
+	 *
+	 * SR（上記）の次にDRを読み込むとIDLEとエラーフラグはクリアされます
+	 * オーバーランの場合、DRのバイトは残って、新しいバイトは失われます
+	 */
+	usart_recv(u->port);
+
+	if (sr & USART_SR_ORE) {
+		u->stats.overrun_errors++;
+	}
+	if (sr & USART_SR_NE) {
+		u->stats.noise_errors++;
+	}
+	if (sr & USART_SR_FE) {
+		u->stats.framing_errors++;
+	}
+	if (sr & USART_SR_PE) {
+		u->stats.parity_errors++;
+	}
+
+	/*
+	 * Line idle(i.e. the end of a burst) or an error,
+	 * anyway take what DMA has received so far
+	 *
+	 * ラインのアイドル（つまり一連の受信の終わり）またはエラー、
+	 * いずれにしてもDMAが今まで受信した分を取ります
+	 */
+	_yusart_rx_dma_drain_irq(u);
 }
 
-static void yusart_deinit(void)
+static void yusart_deinit(struct yusart *u)
 {
 	cm_disable_interrupts();
 
-	usart_disable(DEFAULT_USART_PORT);
-	nvic_disable_irq(NVIC_USART1_IRQ);
-	yusart_interrupt_disable();
-	YRingBufferDestory(&_yusart_rx_rb);
+	if (u->tx_dma) {
+		_yusart_tx_dma_deinit(u);
+	} else {
+		_yusart_tx_irq_deinit(u);
+	}
+	_yusart_rx_dma_deinit(u);
+	usart_disable(u->port);
+	nvic_disable_irq(u->nvic_irq);
+	yusart_interrupt_disable(u);
+	YRingBufferDestory(&(u->rx_rb));
+	u->is_inited = 0;
 
-	rcc_periph_clock_disable(DEFAULT_USART_GPIO_RCC);
-	rcc_periph_clock_disable(DEFAULT_USART_RCC);
+	/*
+	 * The GPIO clock is left enabled, other USARTs or devices may share the bank
+	 *
+	 * GPIOのクロックは有効のままにします、他のUSARTやデバイスが同じバンクを使うかもしれません
+	 */
+	rcc_periph_clock_disable(u->rcc);
 
 	cm_enable_interrupts();
 }
 
-static int yusart_can_transmit(void)
+static int yusart_can_transmit(void *ctx)
 {
+	struct yusart *u = (struct yusart *)ctx;
 	int ret;
+	if (u == NULL) {
+		return 0;
+	}
 
 	cm_disable_interrupts();
-	//yusart_interrupt_disable();
-	ret = usart_get_flag(DEFAULT_USART_PORT, USART_SR_TXE);
-	//yusart_interrupt_enable();
+	ret = _yusart_tx_has_room_irq(u);
 	cm_enable_interrupts();
 
 	return ret;
 }
 
-static int yusart_can_receive(void)
+static int yusart_can_receive(void *ctx)
 {
+	struct yusart *u = (struct yusart *)ctx;
 	int can;
+	if (u == NULL) {
+		return 0;
+	}
 
 	cm_disable_interrupts();
-	//yusart_interrupt_disable();
-	can = YRingBufferGetSize(&_yusart_rx_rb) > 0;
-	//yusart_interrupt_enable();
+	can = YRingBufferGetCurrentLen(&(u->rx_rb)) > 0;
 	cm_enable_interrupts();
 
 	return can;
 }
 
-static int yusart_io_init(void)
+static int yusart_io_init(void *ctx)
 {
-	yusart_init(USART_BAUDRATE, USART_STOPBITS);
+	struct yusart *u = (struct yusart *)ctx;
+	if (u == NULL) {
+		return -1;
+	}
+
+	yusart_init(u, u->baudrate, USART_STOPBITS);
 
 	return 0;
 }
 
-static int yusart_io_deinit(void)
+static int yusart_io_deinit(void *ctx)
 {
-	yusart_deinit();
+	struct yusart *u = (struct yusart *)ctx;
+	if (u == NULL) {
+		return -1;
+	}
+
+	yusart_deinit(u);
 
 	return 0;
 }
 
-static int yusart_io_read_byte_no_block(uint8_t *b)
+/*
+ * Must be called with interrupts disabled
+ *
+ * 割り込み禁止の状態で呼び出す必要があります
+ */
+static uint16_t _yusart_rx_read_irq(struct yusart *u, uint8_t *buf, uint16_t len, int stop_at_text_end)
+{
+	uint16_t cnt = 0;
+	uint8_t data;
+	while (cnt < len) {
+		if (YRingBufferGetData(&(u->rx_rb), &data, sizeof(data)) != sizeof(data)) {
+			break;
+		}
+		buf[cnt++] = data;
+		if (data == BASIC_IO_TEXT_END_MARK) {
+			if (u->rx_text_end_count > 0) {
+				u->rx_text_end_count--;
+			}
+			if (stop_at_text_end) {
+				break;
+			}
+		}
+	}
+
+	if (u->rx_paused) {
+		_yusart_rx_flow_control_irq(u);
+	}
+
+	if (YRingBufferGetCurrentLen(&(u->rx_rb)) == 0) {
+		/*
+		 * A text end dropped by an overflow is never read, resync here
+		 *
+		 * あふれで捨てられたテキスト終端は読まれないため、ここで合わせ直します
+		 */
+		u->rx_text_end_count = 0;
+	}
+
+	return cnt;
+}
+
+/*
+ * Copy as much as fits into the transmit buffers.
+ * Must be called with interrupts disabled.
+ *
+ * 送信バッファに入るだけコピーします
+ * 割り込み禁止の状態で呼び出す必要があります
+ */
+static uint16_t _yusart_tx_write_irq(struct yusart *u, const uint8_t *data, uint16_t len)
+{
+	uint16_t cnt = 0;
+	uint16_t room;
+	uint8_t fill;
+	if (!u->tx_dma) {
+		cnt = (uint16_t)YRingBufferPutData(&(u->tx_rb), (void *)data, len, 0);
+		if (cnt > 0) {
+			u->stats.tx_bytes += cnt;
+			usart_enable_tx_interrupt(u->port);
+		}
+		return cnt;
+	}
+
+	while (cnt < len) {
+		fill = u->tx_fill;
+		room = YUSART_TRANSMIT_BUFFER_SIZE_BYTE - u->tx_len[fill];
+		if (room == 0) {
+			break;
+		}
+		if (room > len - cnt) {
+			room = len - cnt;
+		}
+		memcpy(u->tx_buffer[fill] + u->tx_len[fill], data + cnt, room);
+		u->stats.tx_bytes += room;
+		u->tx_len[fill] += room;
+		cnt += room;
+		/*
+		 * If DMA is idle, this swaps the buffers and there is room again
+		 *
+		 * DMAが空いている場合、バッファが入れ替わってまた余地ができます
+		 */
+		_yusart_tx_kick_irq(u);
+	}
+
+	return cnt;
+}
+
+static int yusart_io_read_byte_no_block(void *ctx, uint8_t *b)
 {
+	struct yusart *u = (struct yusart *)ctx;
 	int ret = -1;
 	uint8_t data;
+	if (u == NULL) {
+		return -1;
+	}
 
 	cm_disable_interrupts();
-	//yusart_interrupt_disable();
-	if (YRingBufferGetData(&_yusart_rx_rb, &data, sizeof(data)) == sizeof(data)) {
+	if (_yusart_rx_read_irq(u, &data, 1, 0) == 1) {
 		if (b != NULL) {
 			*b = data;
 		}
 		ret = 0;
 	}
-	//yusart_interrupt_enable();
 	cm_enable_interrupts();
 
 	return ret;
 }
 
-static int yusart_io_write_byte_no_block(uint8_t b)
+static int yusart_io_write_byte_no_block(void *ctx, uint8_t b)
 {
+	struct yusart *u = (struct yusart *)ctx;
 	int ret = -1;
+	if (u == NULL) {
+		return -1;
+	}
 
-	cm_disable_interrupts();
-	//yusart_interrupt_disable();
-	if (usart_get_flag(DEFAULT_USART_PORT, USART_SR_TXE)) {
-		usart_send(DEFAULT_USART_PORT, b);
+	uint32_t primask = cm_mask_interrupts(1);
+	if (_yusart_tx_write_irq(u, &b, 1) == 1) {
 		ret = 0;
 	}
-	//yusart_interrupt_enable();
-	cm_enable_interrupts();
+	cm_mask_interrupts(primask);
+
+	return ret;
+}
+
+static int32_t yusart_io_read_no_block(void *ctx, uint8_t *buf, uint16_t len, int stop_at_text_end)
+{
+	struct yusart *u = (struct yusart *)ctx;
+	if (u == NULL || buf == NULL) {
+		return -1;
+	}
+
+	uint32_t primask = cm_mask_interrupts(1);
+	uint16_t cnt = _yusart_rx_read_irq(u, buf, len, stop_at_text_end);
+	cm_mask_interrupts(primask);
+
+	return cnt;
+}
+
+static int32_t yusart_io_write_no_block(void *ctx, const uint8_t *data, uint16_t len)
+{
+	struct yusart *u = (struct yusart *)ctx;
+	if (u == NULL || data == NULL) {
+		return -1;
+	}
+
+	uint32_t primask = cm_mask_interrupts(1);
+	uint16_t cnt = _yusart_tx_write_irq(u, data, len);
+	cm_mask_interrupts(primask);
+
+	return cnt;
+}
+
+static int32_t yusart_io_writev_no_block(void *ctx, const struct basic_io_vec *vec, int vec_count)
+{
+	struct yusart *u = (struct yusart *)ctx;
+	if (u == NULL || vec == NULL) {
+		return -1;
+	}
+
+	int32_t total = 0;
+	uint16_t cnt;
+	int i = 0;
+	uint32_t primask = cm_mask_interrupts(1);
+	while (i < vec_count) {
+		cnt = _yusart_tx_write_irq(u, (const uint8_t *)(vec[i].data), vec[i].len);
+		total += cnt;
+		if (cnt < vec[i].len) {
+			break;
+		}
+
+		i++;
+	}
+	cm_mask_interrupts(primask);
+
+	return total;
+}
+
+/*
+ * Must be called with interrupts disabled
+ *
+ * 割り込み禁止の状態で呼び出す必要があります
+ */
+static int _yusart_is_readable_irq(struct yusart *u, int mode)
+{
+	unsigned long len = YRingBufferGetCurrentLen(&(u->rx_rb));
+	if (mode == BASIC_IO_WAIT_TEXT_END) {
+		return (u->rx_text_end_count > 0 && len > 0)
+				|| len == YRingBufferGetSize(&(u->rx_rb));
+	}
+
+	return len > 0;
+}
+
+/*
+ * The waits fail in an ISR, as the interrupts which would bring data or
+ * make room may not preempt it, so waiting there never ends
+ *
+ * ISRでは待ち合わせは失敗します、データを持ってきたり空きを作ったりする割り込みが
+ * それをプリエンプトできない場合があり、そこで待つと終わらないためです
+ */
+static int yusart_io_wait_readable(void *ctx, int mode, uint16_t timeout_ms)
+{
+	struct yusart *u = (struct yusart *)ctx;
+	if (u == NULL || yos_in_isr()) {
+		return -1;
+	}
+
+	volatile uint32_t *waiters = (mode == BASIC_IO_WAIT_TEXT_END) ?
+									&(u->rx_line_waiters) : &(u->rx_waiters);
+	uint8_t task_id = (uint8_t)yos_get_current_task_id();
+	uint32_t deadline = yos_get_ticks() + _MS_TO_TICKS(timeout_ms);
+	int32_t remaining_ticks;
+	int ret = BASIC_IO_RET_TIMEOUT;
+	while (1) {
+		cm_disable_interrupts();
+		if (_yusart_is_readable_irq(u, mode)) {
+			ret = 0;
+		}
+
+		remaining_ticks = yos_wait_ticks_left(timeout_ms, deadline);
+		if (ret == 0 || remaining_ticks <= 0) {
+			ybitband_clear(waiters, task_id);
+			cm_enable_interrupts();
+			break;
+		}
+
+		if (yos_is_started()) {
+			ybitband_set(waiters, task_id);
+			yos_task_block_irq((uint16_t)remaining_ticks);
+		}
+		cm_enable_interrupts();
+	}
 
 	return ret;
 }
 
+static int yusart_io_wait_writable(void *ctx)
+{
+	struct yusart *u = (struct yusart *)ctx;
+	if (u == NULL || yos_in_isr()) {
+		return -1;
+	}
+
+	while (1) {
+		cm_disable_interrupts();
+		if (_yusart_tx_has_room_irq(u)) {
+			ybitband_clear(&(u->tx_waiters), (uint8_t)yos_get_current_task_id());
+			cm_enable_interrupts();
+			break;
+		}
+
+		if (yos_is_started()) {
+			/*
+			 * Sleep until DMA finishes a buffer(or the TXE interrupt frees half of the ring)
+			 *
+			 * DMAがバッファを送り終わる（またはTXE割り込みがリングの半分を空ける）まで寝ます
+			 */
+			ybitband_set(&(u->tx_waiters), (uint8_t)yos_get_current_task_id());
+			yos_task_block_irq(YOS_WAIT_FOREVER);
+		}
+		/*
+		 * Or just spin before the kernel starts
+		 *
+		 * カーネルが始まる前は単に回ります
+		 */
+		cm_enable_interrupts();
+	}
+
+	return 0;
+}
+
 
 static struct basic_io_port_operations _yusart_io_operations = {
 	.basic_io_port_init = yusart_io_init,
@@ -200,7 +1308,12 @@ static struct basic_io_port_operations _yusart_io_operations = {
 	.basic_io_port_can_read = yusart_can_receive,
 	.basic_io_port_read_byte_no_block = yusart_io_read_byte_no_block,
 	.basic_io_port_can_write = yusart_can_transmit,
-	.basic_io_port_write_byte_no_block = yusart_io_write_byte_no_block
+	.basic_io_port_write_byte_no_block = yusart_io_write_byte_no_block,
+	.basic_io_port_wait_writable = yusart_io_wait_writable,
+	.basic_io_port_wait_readable = yusart_io_wait_readable,
+	.basic_io_port_read_no_block = yusart_io_read_no_block,
+	.basic_io_port_write_no_block = yusart_io_write_no_block,
+	.basic_io_port_writev_no_block = yusart_io_writev_no_block
 };
 
 struct basic_io_port_operations *yusart_io_operations = &_yusart_io_operations;
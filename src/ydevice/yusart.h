@@ -19,10 +19,193 @@ extern "C" {
 #define USART_DATABIT		8
 #define USART_STOPBITS		1
 
+/*
+ * USARTs to have a driver instance for, each takes its own buffers
+ * USART1: PA9/PA10, DMA1 channel 4/5
+ * USART2: PA2/PA3, DMA1 channel 7/6
+ * USART3: PB10/PB11, DMA1 channel 2/3
+ *
+ * ドライバーのインスタンスを持つUSART、それぞれ専用のバッファを使います
+ */
+#define YUSART_ENABLE_USART1	1
+#define YUSART_ENABLE_USART2	0
+#define YUSART_ENABLE_USART3	0
+
+/*
+ * Transmit by DMA(1), or by the TXE interrupt from a ring buffer(0)
+ * for a USART whose DMA channel is used by something else
+ *
+ * DMAで送信する（1）、またはDMAチャネルが他に使われているUSARTの場合、
+ * リングバッファからTXE割り込みで送信する（0）
+ */
+#define YUSART_USART1_TX_DMA	1
+#define YUSART_USART2_TX_DMA	1
+#define YUSART_USART3_TX_DMA	1
+
+/*
+ * Baudrate range. The highest is the clock of the USART / 16,
+ * i.e. 4.5M for USART1(APB2 72MHz) and 2.25M for USART2/3(APB1 36MHz),
+ * and also limited so that half of the DMA receive buffer lasts
+ * YUSART_RX_MAX_LATENCY_US(see below).
+ *
+ * ボーレートの範囲。最大はUSARTのクロック / 16、
+ * つまりUSART1（APB2 72MHz）は4.5M、USART2/3（APB1 36MHz）は2.25Mで、
+ * さらにDMA受信バッファの半分がYUSART_RX_MAX_LATENCY_USの間持つように
+ * 制限されます（下記を参照）
+ */
+#define YUSART_MIN_BAUDRATE		1200
+
 #define YUSART_RECEIVE_BUFFER_SIZE_BYTE			256
 
+/*
+ * With flow control, the sender is stopped when the receive buffer
+ * fills up to the high watermark, and restarted when it is read down
+ * to the low watermark.
+ *
+ * フロー制御ありの場合、受信バッファが上限まで溜まったら送信側を止めて、
+ * 下限まで読み込まれたら再開させます
+ */
+#define YUSART_RX_HIGH_WATERMARK				(YUSART_RECEIVE_BUFFER_SIZE_BYTE * 3 / 4)
+#define YUSART_RX_LOW_WATERMARK					(YUSART_RECEIVE_BUFFER_SIZE_BYTE / 4)
+
+/*
+ * Size of the circular DMA receive buffer. Received bytes are moved from it
+ * to the receive buffer at every half of it, or when the line becomes idle.
+ * If that is delayed until DMA laps the buffer, bytes are overwritten
+ * silently(see struct yusart_stats), so the half/full transfer interrupt
+ * must be served within YUSART_RX_MAX_LATENCY_US, and the highest
+ * baudrate is limited to receive at most half of the buffer in that time.
+ * 512 bytes and 500us allow 4.5M(10 bits a byte, 225 bytes in 500us).
+ *
+ * 循環DMA受信バッファのサイズ。受信したバイトは半分ごとに、
+ * またはラインがアイドルになった時に受信バッファに移されます
+ * それがDMAがバッファを一周するまで遅れると、バイトは黙って上書きされます
+ * （struct yusart_statsを参照）。そのため半分／全部の転送割り込みは
+ * YUSART_RX_MAX_LATENCY_US以内に処理される必要があり、最大ボーレートは
+ * その時間で最大バッファの半分を受信するように制限されます
+ * 512バイトと500usで4.5Mまで使えます（1バイト10ビット、500usで225バイト）
+ */
+#define YUSART_RX_DMA_BUFFER_SIZE_BYTE			512
+#define YUSART_RX_MAX_LATENCY_US				500
+
+/*
+ * Size of each of the two transmit buffers. While DMA sends one of them,
+ * writers fill the other.
+ *
+ * 二つの送信バッファそれぞれのサイズ。DMAが一方を送信している間、
+ * 書き込みはもう一方に溜めます
+ */
+#define YUSART_TRANSMIT_BUFFER_SIZE_BYTE		128
+
 extern struct basic_io_port_operations *yusart_io_operations;
 
+/*
+ * Return the driver instance of USART[usart_no](1-3) to give to basic_io_init()
+ * with yusart_io_operations, which will run at baudrate.
+ * Return NULL if the USART is not enabled above.
+ *
+ * basic_io_init()にyusart_io_operationsと一緒に渡す、USART[usart_no]（1-3）の
+ * ドライバーのインスタンスを戻ります、ボーレートはbaudrateになります
+ * 上記で有効になっていないUSARTの場合、NULLを戻ります
+ */
+void *yusart_io_context(uint8_t usart_no, uint32_t baudrate);
+
+/*
+ * Counters of a port, they only count up
+ *
+ * ポートのカウンター、増える一方です
+ */
+struct yusart_stats {
+	uint32_t rx_bytes;
+	uint32_t tx_bytes;
+	uint32_t overrun_errors;
+	uint32_t noise_errors;
+	uint32_t framing_errors;
+	uint32_t parity_errors;
+	/*
+	 * Received bytes lost because the receive buffer was full
+	 * Neither this nor overrun_errors counts bytes overwritten in the DMA
+	 * receive buffer when its interrupt is served later than
+	 * YUSART_RX_MAX_LATENCY_US(e.g. by a long critical section), they are
+	 * lost silently.
+	 *
+	 * 受信バッファが満杯だったために失った受信バイト
+	 * DMA受信バッファの割り込みがYUSART_RX_MAX_LATENCY_USより遅れて処理された場合
+	 * （例：長いクリティカルセクション）に上書きされたバイトは、これもoverrun_errorsも
+	 * 数えず、黙って失われます
+	 */
+	uint32_t rx_dropped;
+	/*
+	 * Times the sender was stopped by flow control
+	 *
+	 * フロー制御で送信側を止めた回数
+	 */
+	uint32_t rx_pauses;
+};
+
+/*
+ * Copy the counters of USART[usart_no] to stats
+ * Return 0 if done, or -1(e.g. the USART is not initialized)
+ *
+ * USART[usart_no]のカウンターをstatsにコピーします
+ * できた場合0を、その他（例：USARTは初期化されていない）は-1を戻ります
+ */
+int yusart_get_stats(uint8_t usart_no, struct yusart_stats *stats);
+
+/*
+ * Change the baudrate of USART[usart_no] at runtime. Waits until
+ * what is being sent has gone out first.
+ * Return 0 if done, or -1(e.g. out of range)
+ *
+ * USART[usart_no]のボーレートを実行中に変更します
+ * 先に送信中のデータが出ていくまで待ちます
+ * できた場合0を、その他（例：範囲外）は-1を戻ります
+ */
+int yusart_set_baudrate(uint8_t usart_no, uint32_t baudrate);
+
+/*
+ * Return the baudrate of USART[usart_no], or 0 if it is not enabled
+ *
+ * USART[usart_no]のボーレートを戻ります、有効でない場合は0を戻ります
+ */
+uint32_t yusart_get_baudrate(uint8_t usart_no);
+
+/*
+ * Flow control
+ *
+ * RTS_CTS: RTS(driven by the receive buffer watermarks) tells the sender
+ * to stop/restart, and the hardware holds transmitting while CTS is high.
+ * USART1: CTS PA11, RTS PA12 / USART2: CTS PA0, RTS PA1 / USART3: CTS PB13, RTS PB14
+ *
+ * XON_XOFF: XOFF/XON is sent ahead of any pending output to stop/restart
+ * the sender. Only receiving is controlled, XON/XOFF received are passed
+ * through as data.
+ *
+ * フロー制御
+ *
+ * RTS_CTS：RTS（受信バッファの上限／下限で動きます）で送信側を止めたり再開させたりします
+ * CTSがハイの間、ハードウェアは送信を保留します
+ *
+ * XON_XOFF：溜まっている送信データより先にXOFF/XONを送信して送信側を止めたり再開させたりします
+ * 受信のみ制御します、受信したXON/XOFFはデータとしてそのまま渡されます
+ */
+#define YUSART_FLOW_CONTROL_NONE		0
+#define YUSART_FLOW_CONTROL_RTS_CTS		1
+#define YUSART_FLOW_CONTROL_XON_XOFF	2
+
+#define YUSART_XON						0x11
+#define YUSART_XOFF						0x13
+
+/*
+ * Set the flow control of USART[usart_no], before or after it is initialized
+ * Return 0 if done, or -1
+ *
+ * USART[usart_no]のフロー制御を設定します、初期化の前後どちらでも呼び出せます
+ * できた場合0を、その他は-1を戻ります
+ */
+int yusart_set_flow_control(uint8_t usart_no, uint8_t flow_control);
+uint8_t yusart_get_flow_control(uint8_t usart_no);
+
 #ifdef __cplusplus
 }
 #endif
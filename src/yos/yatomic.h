@@ -0,0 +1,163 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#ifndef _Y_ATOMIC_H_
+#define _Y_ATOMIC_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Atomic operations by exclusive load/store(LDREX/STREX) of Cortex-M3
+ *
+ * None of these masks interrupts. If the exclusive access is broken by
+ * an interrupt(the exclusive monitor is cleared on exception entry and
+ * return), the store fails and the operation is simply retried.
+ * So they can be used in both tasks and ISRs.
+ *
+ * Cortex-M3の排他ロード／ストア（LDREX/STREX）によるアトミック操作
+ *
+ * どれも割り込みをマスクしません。排他アクセスが割り込みで中断された場合
+ * （例外の出入りで排他モニターはクリアされます）、ストアは失敗して
+ * 操作はやり直されるだけです。
+ * そのため、タスクでもISRでも利用できます
+ */
+
+/*
+ * Data memory barrier
+ *
+ * データメモリバリア
+ */
+static inline void yatomic_barrier(void)
+{
+	__asm__ __volatile__ ("dmb" : : : "memory");
+}
+
+#define _YATOMIC_LDREX(sfx, ptr, val)									\
+	__asm__ __volatile__ (												\
+		"ldrex" sfx " %0, [%1]"											\
+		: "=r"(val)														\
+		: "r"(ptr)														\
+		: "memory"														\
+	)
+
+#define _YATOMIC_STREX(sfx, ptr, val, fail)								\
+	__asm__ __volatile__ (												\
+		"strex" sfx " %0, %2, [%1]"										\
+		: "=&r"(fail)													\
+		: "r"(ptr), "r"(val)											\
+		: "memory"														\
+	)
+
+#define _YATOMIC_CLREX()												\
+	__asm__ __volatile__ ("clrex" : : : "memory")
+
+/*
+ * yatomic_cas{8,16,32}(ptr, expected, desired)
+ *   If *ptr equals expected, set it to desired and return 1,
+ *   or leave it unchanged and return 0.
+ *
+ * yatomic_fetch_add{8,16,32}(ptr, val)
+ *   *ptr += val, return the old value
+ *
+ * yatomic_fetch_or{8,16,32}(ptr, bits)
+ *   Set bits in *ptr, return the old value
+ *
+ * yatomic_fetch_and{8,16,32}(ptr, mask)
+ *   Keep only the bits in mask(i.e. clear bits not in mask), return the old value
+ *
+ *
+ * yatomic_cas{8,16,32}(ptr, expected, desired)
+ *   *ptrがexpectedと等しい場合、desiredに設定して1を戻ります
+ *   その他の場合、変更せずに0を戻ります
+ *
+ * yatomic_fetch_add{8,16,32}(ptr, val)
+ *   *ptr += val、元の値を戻ります
+ *
+ * yatomic_fetch_or{8,16,32}(ptr, bits)
+ *   *ptrのbitsをセットして、元の値を戻ります
+ *
+ * yatomic_fetch_and{8,16,32}(ptr, mask)
+ *   maskにあるビットだけを残して（つまりmaskにないビットをクリアして）、元の値を戻ります
+ */
+#define _YATOMIC_DEFINE(bits, type, sfx)								\
+static inline int yatomic_cas##bits(volatile type *ptr,					\
+									type expected, type desired)		\
+{																		\
+	uint32_t old;														\
+	uint32_t fail;														\
+	do {																\
+		_YATOMIC_LDREX(sfx, ptr, old);									\
+		if ((type)old != expected) {									\
+			_YATOMIC_CLREX();											\
+			return 0;													\
+		}																\
+		_YATOMIC_STREX(sfx, ptr, (uint32_t)desired, fail);				\
+	} while (fail);														\
+																		\
+	return 1;															\
+}																		\
+																		\
+static inline type yatomic_fetch_add##bits(volatile type *ptr, type val)	\
+{																		\
+	uint32_t old;														\
+	uint32_t fail;														\
+	do {																\
+		_YATOMIC_LDREX(sfx, ptr, old);									\
+		_YATOMIC_STREX(sfx, ptr, (uint32_t)(type)(old + val), fail);	\
+	} while (fail);														\
+																		\
+	return (type)old;													\
+}																		\
+																		\
+static inline type yatomic_fetch_or##bits(volatile type *ptr, type bits_to_set)	\
+{																		\
+	uint32_t old;														\
+	uint32_t fail;														\
+	do {																\
+		_YATOMIC_LDREX(sfx, ptr, old);									\
+		_YATOMIC_STREX(sfx, ptr, (uint32_t)(type)(old | bits_to_set), fail);	\
+	} while (fail);														\
+																		\
+	return (type)old;													\
+}																		\
+																		\
+static inline type yatomic_fetch_and##bits(volatile type *ptr, type mask)	\
+{																		\
+	uint32_t old;														\
+	uint32_t fail;														\
+	do {																\
+		_YATOMIC_LDREX(sfx, ptr, old);									\
+		_YATOMIC_STREX(sfx, ptr, (uint32_t)(type)(old & mask), fail);	\
+	} while (fail);														\
+																		\
+	return (type)old;													\
+}
+
+_YATOMIC_DEFINE(8, uint8_t, "b")
+_YATOMIC_DEFINE(16, uint16_t, "h")
+_YATOMIC_DEFINE(32, uint32_t, "")
+
+/*
+ * Set/clear bits, return the old value
+ *
+ * ビットをセット／クリアして、元の値を戻ります
+ */
+#define yatomic_set_bits8(ptr, bits)		yatomic_fetch_or8((ptr), (bits))
+#define yatomic_set_bits16(ptr, bits)		yatomic_fetch_or16((ptr), (bits))
+#define yatomic_set_bits32(ptr, bits)		yatomic_fetch_or32((ptr), (bits))
+#define yatomic_clear_bits8(ptr, bits)		yatomic_fetch_and8((ptr), (uint8_t)~(bits))
+#define yatomic_clear_bits16(ptr, bits)		yatomic_fetch_and16((ptr), (uint16_t)~(bits))
+#define yatomic_clear_bits32(ptr, bits)		yatomic_fetch_and32((ptr), (uint32_t)~(bits))
+
+#ifdef __cplusplus
+}
+#endif
+#endif
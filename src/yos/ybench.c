@@ -0,0 +1,702 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/nvic.h>
+#include <stdint.h>
+#include "yos.h"
+#include "ymutex.h"
+#include "yatomic.h"
+#include "ybitband.h"
+#include "yrwlock.h"
+#include "ytimer.h"
+#include "ybench.h"
+#include "../../lib/yfmt/yfmt.h"
+#if (YBENCH_WITH_NEWLIB_PRINTF == 1)
+#include <stdio.h>
+#endif
+
+#define _YBENCH_LOOPS					64
+#define _YBENCH_ROUNDS					8
+
+#define _YBENCH_STACK_PATTERN			0xA5A5A5A5
+
+/*
+ * Unused IRQ pended by software to measure the interrupt latency
+ *
+ * 割り込みレイテンシを測るためにソフトウェアでペンディングする未使用のIRQ
+ */
+#define _YBENCH_LATENCY_IRQ				NVIC_EXTI0_IRQ
+#define _YBENCH_LATENCY_ISR				exti0_isr
+
+/*
+ * Length of the critical section held while the IRQ is pending
+ *
+ * IRQがペンディング中に保持するクリティカルセクションの長さ
+ */
+#define _YBENCH_LATENCY_HOLD_LOOPS		32
+
+/*
+ * Mixed load(ld_*): the reader tasks and the bench task read, and the
+ * writer task writes once a tick, each holding the lock for
+ * _YBENCH_LOAD_HOLD_LOOPS, so that holders are often preempted.
+ * Each body call runs for _YBENCH_LOAD_TICKS.
+ *
+ * 混合負荷（ld_*）：リーダータスクとベンチタスクが読み込み、ライタータスクは
+ * tickごとに一回書き込みます。それぞれロックを_YBENCH_LOAD_HOLD_LOOPSの間保持し、
+ * 保持中によくプリエンプトされるようにします
+ * body一回の呼び出しは_YBENCH_LOAD_TICKSの間動きます
+ */
+#define _YBENCH_LOAD_READER_COUNT		2
+#define _YBENCH_LOAD_TASK_COUNT			(_YBENCH_LOAD_READER_COUNT + 1)
+#define _YBENCH_LOAD_TASK_STACK_SIZE	384
+#define _YBENCH_LOAD_HOLD_LOOPS			1000
+#define _YBENCH_LOAD_TICKS				2
+
+#define _YBENCH_LOAD_NONE				0
+#define _YBENCH_LOAD_RWLOCK				1
+#define _YBENCH_LOAD_MUTEX				2
+#define _YBENCH_FMT_BUFFER_SIZE			48
+
+struct _ybench_item {
+	const char *name;
+	void (*body)(uint32_t loops);
+	/*
+	 * Optional, called before/after measuring, not counted
+	 * setup returns 0 if ok, or the item is skipped
+	 *
+	 * オプション、測定の前／後に呼び出され、計測に含まれません
+	 * setupはできた場合0を戻ります、その他の場合項目はスキップされます
+	 */
+	int (*setup)(void);
+	void (*teardown)(void);
+	/*
+	 * Optional, if given, what it returns is reported instead of
+	 * the cycles per operation
+	 *
+	 * オプション、指定した場合、操作一回のサイクル数の代わりにこの戻り値を報告します
+	 */
+	uint32_t (*result)(void);
+};
+
+static volatile uint32_t _ybench_counter;
+static char _ybench_fmt_buffer[_YBENCH_FMT_BUFFER_SIZE];
+static struct ymutex _ybench_mutex;
+static struct yrwlock _ybench_rwlock;
+
+static void _ybench_empty(uint32_t loops)
+{
+	while (loops--) {
+		__asm__ __volatile__ ("" : : : "memory");
+	}
+}
+
+static void _ybench_irq_mask(uint32_t loops)
+{
+	while (loops--) {
+		cm_disable_interrupts();
+		cm_enable_interrupts();
+	}
+}
+
+static void _ybench_sched_lock(uint32_t loops)
+{
+	while (loops--) {
+		yos_sched_lock();
+		yos_sched_unlock();
+	}
+}
+
+/*
+ * Mutex lock/unlock as it was done by masking interrupts, for comparison
+ *
+ * 比較用、割り込みをマスクしていた時のmutexの取得／解放
+ */
+static void _ybench_mutex_irq(uint32_t loops)
+{
+	volatile int *owner = &(_ybench_mutex.owner);
+	while (loops--) {
+		cm_disable_interrupts();
+		if (*owner < 0) {
+			*owner = 0;
+		}
+		cm_enable_interrupts();
+
+		cm_disable_interrupts();
+		if (*owner == 0) {
+			*owner = -1;
+		}
+		cm_enable_interrupts();
+	}
+}
+
+static void _ybench_mutex_atomic(uint32_t loops)
+{
+	while (loops--) {
+		ymutex_try_lock(&_ybench_mutex);
+		ymutex_unlock(&_ybench_mutex);
+	}
+}
+
+static void _ybench_inc_irq(uint32_t loops)
+{
+	while (loops--) {
+		cm_disable_interrupts();
+		_ybench_counter++;
+		cm_enable_interrupts();
+	}
+}
+
+static void _ybench_inc_atomic(uint32_t loops)
+{
+	while (loops--) {
+		yatomic_fetch_add32(&_ybench_counter, 1);
+	}
+}
+
+static void _ybench_bit_irq(uint32_t loops)
+{
+	while (loops--) {
+		cm_disable_interrupts();
+		_ybench_counter |= (1UL << 5);
+		cm_enable_interrupts();
+		cm_disable_interrupts();
+		_ybench_counter &= ~(1UL << 5);
+		cm_enable_interrupts();
+	}
+}
+
+static void _ybench_bit_bitband(uint32_t loops)
+{
+	while (loops--) {
+		ybitband_set(&_ybench_counter, 5);
+		ybitband_clear(&_ybench_counter, 5);
+	}
+}
+
+static void _ybench_rwlock_read(uint32_t loops)
+{
+	while (loops--) {
+		yrwlock_try_read_lock(&_ybench_rwlock);
+		yrwlock_read_unlock(&_ybench_rwlock);
+	}
+}
+
+/*
+ * Read-mostly load, one write per eight operations
+ *
+ * 読み込み中心の負荷、8回の操作ごとに1回の書き込み
+ */
+static void _ybench_rwlock_mixed(uint32_t loops)
+{
+	while (loops--) {
+		if ((loops & 0x07) == 0) {
+			yrwlock_try_write_lock(&_ybench_rwlock);
+			yrwlock_write_unlock(&_ybench_rwlock);
+		} else {
+			yrwlock_try_read_lock(&_ybench_rwlock);
+			yrwlock_read_unlock(&_ybench_rwlock);
+		}
+	}
+}
+
+#if (YBENCH_WITH_LOAD_TASKS == 1)
+static int _ybench_load_task_ids[_YBENCH_LOAD_TASK_COUNT];
+static int _ybench_load_is_ready = 0;
+static volatile uint8_t _ybench_load_kind = _YBENCH_LOAD_NONE;
+static volatile uint32_t _ybench_load_ops;
+static uint32_t _ybench_load_start_ticks;
+static uint32_t _ybench_load_ticks;
+
+/*
+ * Bit [task id] is set while the load task is running, cleared when it
+ * suspends itself
+ *
+ * 負荷タスクが動いている間ビット[タスクid]がセットされ、自身を一時停止する時にクリアされます
+ */
+static volatile uint32_t _ybench_load_running;
+
+static void _ybench_load_hold(void)
+{
+	uint32_t i = _YBENCH_LOAD_HOLD_LOOPS;
+	while (i--) {
+		__asm__ __volatile__ ("" : : : "memory");
+	}
+}
+
+static void _ybench_load_read(uint8_t kind)
+{
+	if (kind == _YBENCH_LOAD_RWLOCK) {
+		yrwlock_read_lock(&_ybench_rwlock, YOS_WAIT_FOREVER);
+		_ybench_load_hold();
+		yrwlock_read_unlock(&_ybench_rwlock);
+	} else {
+		ymutex_lock(&_ybench_mutex);
+		_ybench_load_hold();
+		ymutex_unlock(&_ybench_mutex);
+	}
+	yatomic_fetch_add32(&_ybench_load_ops, 1);
+}
+
+/*
+ * Park the calling load task until the next ld_* item.
+ * The scheduler is locked so that the bench task cannot resume it
+ * between clearing the bit and suspending.
+ *
+ * 呼び出した負荷タスクを次のld_*項目まで待機させます
+ * ビットのクリアと一時停止の間にベンチタスクが再開させないように、
+ * スケジューラーをロックします
+ */
+static void _ybench_load_park(void)
+{
+	int task_id = yos_get_current_task_id();
+	yos_sched_lock();
+	ybitband_clear(&_ybench_load_running, (uint8_t)task_id);
+	yos_task_suspend(task_id);
+	yos_sched_unlock();
+}
+
+static int _ybench_load_reader_task(void *data)
+{
+	uint8_t kind;
+	while (1) {
+		kind = _ybench_load_kind;
+		if (kind == _YBENCH_LOAD_NONE) {
+			_ybench_load_park();
+			continue;
+		}
+
+		_ybench_load_read(kind);
+	}
+
+	return 0;
+}
+
+static int _ybench_load_writer_task(void *data)
+{
+	uint8_t kind;
+	while (1) {
+		kind = _ybench_load_kind;
+		if (kind == _YBENCH_LOAD_NONE) {
+			_ybench_load_park();
+			continue;
+		}
+
+		if (kind == _YBENCH_LOAD_RWLOCK) {
+			yrwlock_write_lock(&_ybench_rwlock, YOS_WAIT_FOREVER);
+			_ybench_load_hold();
+			yrwlock_write_unlock(&_ybench_rwlock);
+		} else {
+			ymutex_lock(&_ybench_mutex);
+			_ybench_load_hold();
+			ymutex_unlock(&_ybench_mutex);
+		}
+		yos_task_delay(1);
+	}
+
+	return 0;
+}
+
+int ybench_create_load_tasks(void)
+{
+	int i = 0;
+	while (i < _YBENCH_LOAD_TASK_COUNT) {
+		_ybench_load_task_ids[i] = yos_create_task(
+				(i < _YBENCH_LOAD_READER_COUNT) ? _ybench_load_reader_task : _ybench_load_writer_task,
+				NULL, _YBENCH_LOAD_TASK_STACK_SIZE, (i < _YBENCH_LOAD_READER_COUNT) ? "bchrd" : "bchwr");
+		if (_ybench_load_task_ids[i] < 0) {
+			return -1;
+		}
+
+		i++;
+	}
+	_ybench_load_is_ready = 1;
+
+	return 0;
+}
+
+static int _ybench_load_start(uint8_t kind)
+{
+	if (!_ybench_load_is_ready) {
+		return -1;
+	}
+
+	_ybench_load_ops = 0;
+	_ybench_load_kind = kind;
+	_ybench_load_start_ticks = yos_get_ticks();
+	int i = 0;
+	while (i < _YBENCH_LOAD_TASK_COUNT) {
+		ybitband_set(&_ybench_load_running, (uint8_t)_ybench_load_task_ids[i]);
+		yos_task_resume(_ybench_load_task_ids[i]);
+		i++;
+	}
+
+	return 0;
+}
+
+static int _ybench_load_rwlock_setup(void)
+{
+	return _ybench_load_start(_YBENCH_LOAD_RWLOCK);
+}
+
+static int _ybench_load_mutex_setup(void)
+{
+	return _ybench_load_start(_YBENCH_LOAD_MUTEX);
+}
+
+static void _ybench_load_teardown(void)
+{
+	_ybench_load_ticks = yos_get_ticks() - _ybench_load_start_ticks;
+	_ybench_load_kind = _YBENCH_LOAD_NONE;
+
+	/*
+	 * Wait until all the load tasks are parked, out of the locks
+	 *
+	 * すべての負荷タスクがロックの外で待機するまで待ちます
+	 */
+	while (_ybench_load_running != 0) {
+		yos_task_delay(1);
+	}
+}
+
+static uint32_t _ybench_load_result(void)
+{
+	if (_ybench_load_ticks == 0) {
+		return 0;
+	}
+
+	return _ybench_load_ops / _ybench_load_ticks;
+}
+
+/*
+ * Read for _YBENCH_LOAD_TICKS together with the reader tasks
+ *
+ * リーダータスクと一緒に_YBENCH_LOAD_TICKSの間読み込みます
+ */
+static void _ybench_load_body(uint32_t loops)
+{
+	uint8_t kind = _ybench_load_kind;
+	uint32_t start = yos_get_ticks();
+	while (yos_get_ticks() - start < _YBENCH_LOAD_TICKS) {
+		_ybench_load_read(kind);
+	}
+}
+#endif
+
+/*
+ * Format the same text by newlib snprintf() / by yfmt, for comparison
+ *
+ * 比較用、newlibのsnprintf()／yfmtで同じテキストをフォーマットします
+ */
+#if (YBENCH_WITH_NEWLIB_PRINTF == 1)
+static void _ybench_fmt_std(uint32_t loops)
+{
+	while (loops--) {
+		snprintf(_ybench_fmt_buffer, sizeof(_ybench_fmt_buffer), "%02u H %-8lu %04X %s",
+					(unsigned int)(loops & 0x3F), (unsigned long)loops * 12345UL,
+					(unsigned int)loops, "yos");
+	}
+}
+#endif
+
+static void _ybench_fmt_yfmt(uint32_t loops)
+{
+	while (loops--) {
+		yfmt_snprintf(_ybench_fmt_buffer, sizeof(_ybench_fmt_buffer), "%02u H %-8lu %04X %s",
+					(unsigned int)(loops & 0x3F), (unsigned long)loops * 12345UL,
+					(unsigned int)loops, "yos");
+	}
+}
+
+/*
+ * One ms tick of the user timer wheel, with 8/32/128 timers armed
+ *
+ * 8/32/128個のタイマーが動いている状態での、ユーザータイマーのホイールの1ms tick
+ */
+static void _ybench_timer_tick(uint32_t loops)
+{
+	while (loops--) {
+		user_timer_bench_tick();
+	}
+}
+
+static int _ybench_timer_8_setup(void)
+{
+	return user_timer_bench_start(8);
+}
+
+static int _ybench_timer_32_setup(void)
+{
+	return user_timer_bench_start(32);
+}
+
+static int _ybench_timer_128_setup(void)
+{
+	return user_timer_bench_start(128);
+}
+
+static volatile uint32_t _ybench_irq_cycles;
+static uint32_t _ybench_min_latency;
+
+void _YBENCH_LATENCY_ISR(void)
+{
+	_ybench_irq_cycles = dwt_read_cycle_counter();
+}
+
+static void _ybench_latency_hold(void)
+{
+	uint32_t i = _YBENCH_LATENCY_HOLD_LOOPS;
+	while (i--) {
+		__asm__ __volatile__ ("" : : : "memory");
+	}
+}
+
+/*
+ * Pend the IRQ inside the critical section of the kind, and take the
+ * cycles from pending to the entry of its handler
+ *
+ * 種類ごとのクリティカルセクションの中でIRQをペンディングして、
+ * ペンディングからハンドラーに入るまでのサイクル数を取ります
+ */
+#define _YBENCH_LATENCY_BODY(enter, exit)										\
+	uint32_t start;																\
+	uint32_t latency;															\
+	while (loops--) {															\
+		_ybench_irq_cycles = 0;													\
+		enter;																	\
+		start = dwt_read_cycle_counter();										\
+		nvic_set_pending_irq(_YBENCH_LATENCY_IRQ);								\
+		_ybench_latency_hold();													\
+		exit;																	\
+		while (_ybench_irq_cycles == 0) {										\
+		}																		\
+		latency = _ybench_irq_cycles - start;									\
+		if (latency < _ybench_min_latency) {									\
+			_ybench_min_latency = latency;										\
+		}																		\
+	}
+
+static void _ybench_latency_none(uint32_t loops)
+{
+	_YBENCH_LATENCY_BODY(, )
+}
+
+static void _ybench_latency_irq(uint32_t loops)
+{
+	_YBENCH_LATENCY_BODY(cm_disable_interrupts(), cm_enable_interrupts())
+}
+
+static void _ybench_latency_sched(uint32_t loops)
+{
+	_YBENCH_LATENCY_BODY(yos_sched_lock(), yos_sched_unlock())
+}
+
+static int _ybench_latency_setup(void)
+{
+	_ybench_min_latency = 0xFFFFFFFF;
+	nvic_clear_pending_irq(_YBENCH_LATENCY_IRQ);
+	nvic_enable_irq(_YBENCH_LATENCY_IRQ);
+
+	return 0;
+}
+
+static void _ybench_latency_teardown(void)
+{
+	nvic_disable_irq(_YBENCH_LATENCY_IRQ);
+}
+
+static uint32_t _ybench_latency_result(void)
+{
+	return _ybench_min_latency;
+}
+
+static const struct _ybench_item _ybench_items[] = {
+	{"irqmask", _ybench_irq_mask},
+	{"schedlk", _ybench_sched_lock},
+	{"mtx_irq", _ybench_mutex_irq},
+	{"mtx_atm", _ybench_mutex_atomic},
+	{"inc_irq", _ybench_inc_irq},
+	{"inc_atm", _ybench_inc_atomic},
+	{"bit_irq", _ybench_bit_irq},
+	{"bit_bb", _ybench_bit_bitband},
+	{"rw_rd", _ybench_rwlock_read},
+	{"rw_mix", _ybench_rwlock_mixed},
+#if (YBENCH_WITH_LOAD_TASKS == 1)
+	{"ld_rw", _ybench_load_body, _ybench_load_rwlock_setup, _ybench_load_teardown,
+		_ybench_load_result},
+	{"ld_mtx", _ybench_load_body, _ybench_load_mutex_setup, _ybench_load_teardown,
+		_ybench_load_result},
+#endif
+#if (YBENCH_WITH_NEWLIB_PRINTF == 1)
+	{"fmt_std", _ybench_fmt_std},
+#endif
+	{"fmt_y", _ybench_fmt_yfmt},
+	{"tmr_8", _ybench_timer_tick, _ybench_timer_8_setup, user_timer_bench_stop},
+	{"tmr_32", _ybench_timer_tick, _ybench_timer_32_setup, user_timer_bench_stop},
+	{"tmr_128", _ybench_timer_tick, _ybench_timer_128_setup, user_timer_bench_stop},
+	{"lat_none", _ybench_latency_none, _ybench_latency_setup, _ybench_latency_teardown,
+		_ybench_latency_result},
+	{"lat_irq", _ybench_latency_irq, _ybench_latency_setup, _ybench_latency_teardown,
+		_ybench_latency_result},
+	{"lat_sch", _ybench_latency_sched, _ybench_latency_setup, _ybench_latency_teardown,
+		_ybench_latency_result}
+};
+
+#define _YBENCH_ITEM_COUNT		((int)(sizeof(_ybench_items) / sizeof(_ybench_items[0])))
+
+static uint32_t _ybench_measure(void (*body)(uint32_t loops))
+{
+	uint32_t start;
+	uint32_t cycles;
+	uint32_t min_cycles = 0xFFFFFFFF;
+	int i = 0;
+	while (i < _YBENCH_ROUNDS) {
+		start = dwt_read_cycle_counter();
+		body(_YBENCH_LOOPS);
+		cycles = dwt_read_cycle_counter() - start;
+		if (cycles < min_cycles) {
+			min_cycles = cycles;
+		}
+
+		i++;
+	}
+
+	return min_cycles;
+}
+
+/*
+ * Paint the free stack below SP with a pattern, run body once, and find
+ * the deepest word overwritten.
+ * Interrupts coming in between also leave their frames, so the minimum of
+ * several rounds is taken, like the cycles.
+ *
+ * SPより下の空きスタックをパターンで塗って、bodyを一回実行して、
+ * 上書きされた一番深いワードを探します
+ * その間に来た割り込みもフレームを残しますので、サイクル数と同様に数回の最小値を取ります
+ */
+static __attribute__((noinline)) uint32_t _ybench_measure_stack(void (*body)(uint32_t loops))
+{
+	uint32_t sp;
+	uint32_t *bottom;
+	uint32_t *p;
+	uint32_t used;
+	uint32_t min_used = 0xFFFFFFFF;
+	uint32_t left = yos_task_get_stack_left();
+	int i = 0;
+	if (left == 0) {
+		return 0;
+	}
+
+	while (i < _YBENCH_ROUNDS) {
+		__asm__ __volatile__ (
+			"mov %0, sp"
+			: "=r"(sp)
+			:
+			:
+		);
+		bottom = (uint32_t *)((sp - left + 3) & ~3UL);
+
+		p = bottom;
+		while ((uint32_t)p < sp) {
+			*p++ = _YBENCH_STACK_PATTERN;
+		}
+
+		body(1);
+
+		p = bottom;
+		while ((uint32_t)p < sp && *p == _YBENCH_STACK_PATTERN) {
+			p++;
+		}
+
+		used = sp - (uint32_t)p;
+		if (used < min_used) {
+			min_used = used;
+		}
+
+		i++;
+	}
+
+	return min_used;
+}
+
+int ybench_get_count(void)
+{
+	return _YBENCH_ITEM_COUNT;
+}
+
+const char *ybench_get_name(int index)
+{
+	if (index < 0 || index >= _YBENCH_ITEM_COUNT) {
+		return NULL;
+	}
+
+	return _ybench_items[index].name;
+}
+
+uint32_t ybench_run(int index)
+{
+	if (index < 0 || index >= _YBENCH_ITEM_COUNT) {
+		return 0;
+	}
+
+	dwt_enable_cycle_counter();
+	ymutex_init(&_ybench_mutex);
+	yrwlock_init(&_ybench_rwlock, 1);
+
+	/*
+	 * The minimum of several rounds is taken to leave out interrupts,
+	 * and the loop overhead is subtracted.
+	 *
+	 * 割り込みの影響を除くために数回の最小値を取り、ループのオーバーヘッドを引きます
+	 */
+	const struct _ybench_item *item = _ybench_items + index;
+	uint32_t empty_cycles = _ybench_measure(_ybench_empty);
+	if (item->setup != NULL && item->setup() != 0) {
+		return 0;
+	}
+	uint32_t cycles = _ybench_measure(item->body);
+	if (item->teardown != NULL) {
+		item->teardown();
+	}
+
+	if (item->result != NULL) {
+		return item->result();
+	}
+
+	if (cycles < empty_cycles) {
+		return 0;
+	}
+
+	return (cycles - empty_cycles) / _YBENCH_LOOPS;
+}
+
+uint32_t ybench_run_stack(int index)
+{
+	if (index < 0 || index >= _YBENCH_ITEM_COUNT) {
+		return 0;
+	}
+
+	ymutex_init(&_ybench_mutex);
+	yrwlock_init(&_ybench_rwlock, 1);
+
+	const struct _ybench_item *item = _ybench_items + index;
+	uint32_t empty_used = _ybench_measure_stack(_ybench_empty);
+	if (item->setup != NULL && item->setup() != 0) {
+		return 0;
+	}
+	uint32_t used = _ybench_measure_stack(item->body);
+	if (item->teardown != NULL) {
+		item->teardown();
+	}
+
+	if (used < empty_used) {
+		return 0;
+	}
+
+	return used - empty_used;
+}
@@ -0,0 +1,94 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#ifndef _Y_BENCH_H_
+#define _Y_BENCH_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Micro benchmarks measured by the DWT cycle counter
+ *
+ * DWTサイクルカウンターで測るマイクロベンチマーク
+ */
+
+/*
+ * Add the fmt_std item formatting by newlib snprintf(), to compare with fmt_y.
+ * It links newlib printf, which nothing else in YOS needs any more.
+ *
+ * fmt_yと比較するため、newlibのsnprintf()でフォーマットするfmt_std項目を追加します
+ * newlibのprintfをリンクしますが、YOSの他の部分はもう必要としません
+ */
+#define YBENCH_WITH_NEWLIB_PRINTF		0
+
+/*
+ * Add the ld_rw/ld_mtx items, reading under a mixed load with two more
+ * reader tasks and a writer task. The three tasks are created by
+ * ybench_create_load_tasks() and stay suspended except while measuring.
+ *
+ * 他に二つのリーダータスクと一つのライタータスクがある混合負荷の下で読み込む
+ * ld_rw／ld_mtx項目を追加します。三つのタスクはybench_create_load_tasks()で
+ * 作成され、測定中以外は一時停止したままです
+ */
+#define YBENCH_WITH_LOAD_TASKS			1
+
+/*
+ * Get count of benchmark items
+ *
+ * ベンチマーク項目の数を取得します
+ */
+int ybench_get_count(void);
+
+/*
+ * Get name of the benchmark item, or NULL if index is invalid
+ *
+ * ベンチマーク項目の名前を取得します、indexが無効の場合はNULLを戻ります
+ */
+const char *ybench_get_name(int index);
+
+/*
+ * Run the benchmark item and return CPU cycles taken per operation
+ * (the interrupt latency in cycles for lat_*, read operations per tick
+ * for ld_*), or 0 if the item cannot be run now(e.g. tmr_* while user
+ * timers are in use)
+ *
+ * ベンチマーク項目を実行して、操作一回にかかったCPUサイクル数
+ * （lat_*の場合サイクル数での割り込みレイテンシ、ld_*の場合tickごとの読み込み回数）を戻ります
+ * 項目を今実行できない場合（例：ユーザータイマー使用中のtmr_*）0を戻ります
+ */
+uint32_t ybench_run(int index);
+
+/*
+ * Run the benchmark item once and return stack bytes used by the operation,
+ * or 0 if yos is not started
+ * The stack of the calling task must have room for the operation.
+ *
+ * ベンチマーク項目を一回実行して、操作で使ったスタックのバイト数を戻ります
+ * yosが開始していない場合0を戻ります
+ * 呼び出し元タスクのスタックには操作のための余裕が必要です
+ */
+uint32_t ybench_run_stack(int index);
+
+#if (YBENCH_WITH_LOAD_TASKS == 1)
+/*
+ * Create the load tasks for ld_*, call it before yos_start()
+ * Return 0 if created, or -1
+ *
+ * ld_*のための負荷タスクを作成します、yos_start()の前に呼び出してください
+ * 作成できた場合0を、その他は-1を戻ります
+ */
+int ybench_create_load_tasks(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif
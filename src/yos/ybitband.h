@@ -0,0 +1,104 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#ifndef _Y_BITBAND_H_
+#define _Y_BITBAND_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Bit-band of Cortex-M3
+ *
+ * Every bit in the first 1 MB of SRAM and of the peripheral region is
+ * mapped to a whole word in the alias region. Writing 0/1 to the alias
+ * word clears/sets the bit by a single store, so no read-modify-write
+ * race can happen and no critical section is needed, even against ISRs.
+ *
+ * Only variables in SRAM(e.g. globals and stacks) and peripheral
+ * registers can be accessed in this way, not those in flash.
+ *
+ * Cortex-M3のビットバンド
+ *
+ * SRAMと周辺機器領域の最初の1MBの各ビットは、エイリアス領域の1ワードに
+ * 対応付けられています。エイリアスワードに0/1を書き込むと、一回のストアで
+ * ビットをクリア／セットしますので、読み込み・変更・書き込みの競合は起きず、
+ * ISRに対してもクリティカルセクションは要りません
+ *
+ * この方法でアクセスできるのはSRAMの変数（例えばグローバル変数やスタック）と
+ * 周辺機器のレジスタのみで、フラッシュにあるものはできません
+ */
+#define YBITBAND_SRAM_BASE				0x20000000UL
+#define YBITBAND_SRAM_ALIAS_BASE		0x22000000UL
+#define YBITBAND_PERIPH_BASE			0x40000000UL
+#define YBITBAND_PERIPH_ALIAS_BASE		0x42000000UL
+#define YBITBAND_REGION_SIZE			0x00100000UL
+
+/*
+ * Alias word address of bit [bit](0-31) of the 32-bit word at [addr]
+ *
+ * [addr]にある32ビットワードのビット[bit]（0-31）のエイリアスワードアドレス
+ */
+#define YBITBAND_ALIAS(addr, bit)												\
+	((volatile uint32_t *)(														\
+		(((uint32_t)(addr)) & 0xF0000000UL) + 0x02000000UL						\
+		+ ((((uint32_t)(addr)) & 0x000FFFFFUL) << 5) + (((uint32_t)(bit)) << 2)))
+
+static inline void ybitband_set(volatile uint32_t *addr, uint8_t bit)
+{
+	*YBITBAND_ALIAS(addr, bit) = 1;
+}
+
+static inline void ybitband_clear(volatile uint32_t *addr, uint8_t bit)
+{
+	*YBITBAND_ALIAS(addr, bit) = 0;
+}
+
+static inline void ybitband_write(volatile uint32_t *addr, uint8_t bit, int value)
+{
+	*YBITBAND_ALIAS(addr, bit) = (value ? 1 : 0);
+}
+
+static inline int ybitband_get(volatile uint32_t *addr, uint8_t bit)
+{
+	return (int)(*YBITBAND_ALIAS(addr, bit));
+}
+
+/*
+ * Bitmap of any number of bits on an array of 32-bit words
+ *
+ * 32ビットワードの配列による任意ビット数のビットマップ
+ */
+#define YBITMAP_WORDS(bits)				(((bits) + 31) / 32)
+
+static inline void ybitmap_set(volatile uint32_t *map, uint32_t index)
+{
+	ybitband_set(map + (index >> 5), index & 0x1F);
+}
+
+static inline void ybitmap_clear(volatile uint32_t *map, uint32_t index)
+{
+	ybitband_clear(map + (index >> 5), index & 0x1F);
+}
+
+static inline void ybitmap_write(volatile uint32_t *map, uint32_t index, int value)
+{
+	ybitband_write(map + (index >> 5), index & 0x1F, value);
+}
+
+static inline int ybitmap_get(volatile uint32_t *map, uint32_t index)
+{
+	return ybitband_get(map + (index >> 5), index & 0x1F);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
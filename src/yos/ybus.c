@@ -0,0 +1,89 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#include <libopencm3/cm3/cortex.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "yos.h"
+#include "ybus.h"
+#include "ybitband.h"
+#include "yseqlock.h"
+
+int ybus_publish(struct ybus_topic *topic, const void *data, uint16_t size)
+{
+	if (topic == NULL || data == NULL || size != topic->size) {
+		return -1;
+	}
+
+	/*
+	 * Publishers are serialized by masking interrupts, which also keeps
+	 * readers in ISRs from interrupting the write.
+	 *
+	 * パブリッシャーは割り込みのマスクで直列化されます、これでISRのリーダーが
+	 * 書き込みに割り込むこともなくなります
+	 */
+	uint32_t primask = cm_mask_interrupts(1);
+	yseqlock_write_begin(&(topic->seqlock));
+	memcpy(topic->value, data, size);
+	topic->publish_count++;
+	yseqlock_write_end(&(topic->seqlock));
+	cm_mask_interrupts(primask);
+
+	uint32_t subscribers = topic->subscribers;
+	int task_id;
+	while (subscribers != 0) {
+		task_id = __builtin_ctz(subscribers);
+		subscribers &= subscribers - 1;
+		yos_task_notify(task_id, topic->notify_bits);
+	}
+
+	return 0;
+}
+
+int ybus_read(struct ybus_topic *topic, void *buf, uint16_t size, uint32_t *publish_count)
+{
+	if (topic == NULL || buf == NULL || size != topic->size) {
+		return -1;
+	}
+
+	uint32_t sequence;
+	uint32_t count;
+	do {
+		sequence = yseqlock_read_begin(&(topic->seqlock));
+		memcpy(buf, topic->value, size);
+		count = topic->publish_count;
+	} while (yseqlock_read_retry(&(topic->seqlock), sequence));
+
+	if (publish_count != NULL) {
+		*publish_count = count;
+	}
+
+	return (count == 0) ? -1 : 0;
+}
+
+int ybus_subscribe(struct ybus_topic *topic)
+{
+	if (topic == NULL) {
+		return -1;
+	}
+
+	ybitband_set(&(topic->subscribers), (uint8_t)yos_get_current_task_id());
+
+	return 0;
+}
+
+int ybus_unsubscribe(struct ybus_topic *topic)
+{
+	if (topic == NULL) {
+		return -1;
+	}
+
+	ybitband_clear(&(topic->subscribers), (uint8_t)yos_get_current_task_id());
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#ifndef _Y_BUS_H_
+#define _Y_BUS_H_
+
+#include <stdint.h>
+#include "yseqlock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Publish/subscribe data bus
+ *
+ * A topic is declared statically with the type of its payload, and keeps
+ * the latest published value. Readers take a consistent copy of it at any
+ * time without blocking. Subscribed tasks are notified with the topic's
+ * notification bits(see yos_task_notify_wait()) on every publish.
+ *
+ * パブリッシュ／サブスクライブ　データバス
+ *
+ * トピックはペイロードの型と一緒に静的に宣言され、最後にパブリッシュされた値を
+ * 保持します。リーダーはいつでもブロックせずにその整合したコピーを取れます。
+ * サブスクライブしたタスクはパブリッシュのたびにトピックの通知ビットで通知されます
+ * （yos_task_notify_wait()を参照）
+ */
+struct ybus_topic {
+	const char *name;
+	void *value;
+	uint16_t size;
+	uint32_t notify_bits;
+	struct yseqlock seqlock;
+	/*
+	 * How many times it has been published, 0 means no value yet
+	 *
+	 * パブリッシュされた回数、0はまだ値がないことを意味します
+	 */
+	uint32_t publish_count;
+	/*
+	 * Bit [task id] is set for subscribed tasks
+	 *
+	 * サブスクライブしたタスクのビット[タスクid]がセットされます
+	 */
+	volatile uint32_t subscribers;
+};
+
+/*
+ * Define a topic with the payload type and the notification bits sent
+ * to subscribers, and declare it in other files
+ *
+ * ペイロードの型とサブスクライバーに送る通知ビットでトピックを定義します
+ * 他のファイルではYBUS_TOPIC_DECLAREで宣言します
+ */
+#define YBUS_TOPIC_DEFINE(topic, type, bits)							\
+	static type _ybus_value_##topic;									\
+	struct ybus_topic topic = {											\
+		.name = #topic,													\
+		.value = &_ybus_value_##topic,									\
+		.size = sizeof(type),											\
+		.notify_bits = (bits),											\
+		.seqlock = YSEQLOCK_INIT,										\
+		.publish_count = 0,												\
+		.subscribers = 0												\
+	}
+
+#define YBUS_TOPIC_DECLARE(topic)		extern struct ybus_topic topic
+
+/*
+ * Publish/read a variable of the payload type, the size is checked
+ *
+ * ペイロード型の変数をパブリッシュ／読み込みます、サイズはチェックされます
+ */
+#define YBUS_PUBLISH(topic, var)							\
+	ybus_publish(&(topic), &(var), sizeof(var))
+#define YBUS_READ(topic, var, publish_count)				\
+	ybus_read(&(topic), &(var), sizeof(var), (publish_count))
+
+/*
+ * Update the value and notify subscribers, can be called from ISRs.
+ * Return 0 if published, or -1(e.g. size differs from the topic's)
+ *
+ * 値を更新してサブスクライバーに通知します、ISRから呼び出せます
+ * パブリッシュした場合0を、その他（例：サイズがトピックと違う）は-1を戻ります
+ */
+int ybus_publish(struct ybus_topic *topic, const void *data, uint16_t size);
+
+/*
+ * Copy the latest value to buf, and the publish count of it to
+ * publish_count if not NULL.
+ * Return 0 if copied, or -1(e.g. nothing published yet)
+ *
+ * 最新の値をbufに、そのパブリッシュ回数をpublish_count（NULLでない場合）に
+ * コピーします
+ * コピーした場合0を、その他（例：まだパブリッシュされていない）は-1を戻ります
+ */
+int ybus_read(struct ybus_topic *topic, void *buf, uint16_t size, uint32_t *publish_count);
+
+/*
+ * Subscribe/unsubscribe the current task to/from the topic
+ *
+ * 今のタスクをトピックにサブスクライブ／サブスクライブ解除します
+ */
+int ybus_subscribe(struct ybus_topic *topic);
+int ybus_unsubscribe(struct ybus_topic *topic);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
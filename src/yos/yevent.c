@@ -0,0 +1,141 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#include <libopencm3/cm3/cortex.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "yos_core.h"
+#include "yevent.h"
+#include "yatomic.h"
+#include "ybitband.h"
+
+static void _yevent_notify(struct yevent_flags *ev)
+{
+	/*
+	 * The flags are updated before checking the waiters, and a task checks
+	 * the flags and registers itself with interrupts disabled, so no
+	 * wake-up can be lost.
+	 *
+	 * フラグは待ち手のチェックより前に更新され、タスクはフラグのチェックと
+	 * 自分の登録を割り込み禁止の状態で行いますので、起床が失われることは
+	 * ありません
+	 */
+	if (ev->waiters != 0) {
+		uint32_t primask = cm_mask_interrupts(1);
+		yos_task_wake_waiters_irq(&(ev->waiters));
+		cm_mask_interrupts(primask);
+	}
+}
+
+void yevent_flags_init(struct yevent_flags *ev)
+{
+	if (ev == NULL) {
+		return;
+	}
+
+	ev->flags = 0;
+	ev->waiters = 0;
+}
+
+void yevent_flags_set_bit(struct yevent_flags *ev, uint8_t bit)
+{
+	if (ev == NULL || bit >= 32) {
+		return;
+	}
+
+	ybitband_set(&(ev->flags), bit);
+	_yevent_notify(ev);
+}
+
+void yevent_flags_clear_bit(struct yevent_flags *ev, uint8_t bit)
+{
+	if (ev == NULL || bit >= 32) {
+		return;
+	}
+
+	ybitband_clear(&(ev->flags), bit);
+}
+
+void yevent_flags_set(struct yevent_flags *ev, uint32_t bits)
+{
+	if (ev == NULL) {
+		return;
+	}
+
+	yatomic_set_bits32(&(ev->flags), bits);
+	_yevent_notify(ev);
+}
+
+void yevent_flags_clear(struct yevent_flags *ev, uint32_t bits)
+{
+	if (ev == NULL) {
+		return;
+	}
+
+	yatomic_clear_bits32(&(ev->flags), bits);
+}
+
+uint32_t yevent_flags_get(struct yevent_flags *ev)
+{
+	if (ev == NULL) {
+		return 0;
+	}
+
+	return ev->flags;
+}
+
+uint32_t yevent_flags_wait(struct yevent_flags *ev, uint32_t bits,
+							uint8_t options, uint16_t timeout_ms)
+{
+	if (ev == NULL || bits == 0) {
+		return 0;
+	}
+
+	uint32_t got = 0;
+	uint32_t flags;
+	int is_satisfied;
+	int task_id = yos_get_current_task_id();
+	uint32_t deadline = yos_get_ticks() + _MS_TO_TICKS(timeout_ms);
+	int32_t remaining_ticks;
+	while (1) {
+		cm_disable_interrupts();
+		flags = ev->flags;
+		if (options & YEVENT_WAIT_ALL) {
+			is_satisfied = ((flags & bits) == bits);
+		} else {
+			is_satisfied = ((flags & bits) != 0);
+		}
+
+		if (is_satisfied) {
+			got = flags & bits;
+			if (options & YEVENT_CLEAR_ON_EXIT) {
+				yatomic_clear_bits32(&(ev->flags), got);
+			}
+			ybitband_clear(&(ev->waiters), (uint8_t)task_id);
+			cm_enable_interrupts();
+			break;
+		}
+
+		remaining_ticks = yos_wait_ticks_left(timeout_ms, deadline);
+		if (remaining_ticks <= 0) {
+			/*
+			 * Timed out
+			 *
+			 * タイムアウトしました
+			 */
+			ybitband_clear(&(ev->waiters), (uint8_t)task_id);
+			cm_enable_interrupts();
+			break;
+		}
+
+		ybitband_set(&(ev->waiters), (uint8_t)task_id);
+		yos_task_block_irq((uint16_t)remaining_ticks);
+		cm_enable_interrupts();
+	}
+
+	return got;
+}
@@ -0,0 +1,92 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#ifndef _Y_EVENT_H_
+#define _Y_EVENT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Event flag group
+ *
+ * Up to 32 flags, tasks can wait for any or all of them.
+ * Flags can be set/cleared from both tasks and ISRs.
+ *
+ * イベントフラググループ
+ *
+ * 最大32個のフラグ、タスクはそのいずれかまたはすべてを待つことができます
+ * フラグはタスクからもISRからもセット／クリアできます
+ */
+struct yevent_flags {
+	volatile uint32_t flags;
+	/*
+	 * Bit [task id] is set while the task is waiting
+	 *
+	 * 待っているタスクのビット[タスクid]がセットされます
+	 */
+	volatile uint32_t waiters;
+};
+
+/*
+ * Options of yevent_flags_wait()
+ *
+ * YEVENT_WAIT_ALL: Wait until all the bits are set, instead of any of them
+ * YEVENT_CLEAR_ON_EXIT: Clear the satisfied bits before returning
+ *
+ * yevent_flags_wait()のオプション
+ *
+ * YEVENT_WAIT_ALL: いずれかではなく、すべてのビットがセットされるまで待ちます
+ * YEVENT_CLEAR_ON_EXIT: 戻る前に満たされたビットをクリアします
+ */
+#define YEVENT_WAIT_ANY				0x00
+#define YEVENT_WAIT_ALL				0x01
+#define YEVENT_CLEAR_ON_EXIT		0x02
+
+void yevent_flags_init(struct yevent_flags *ev);
+
+/*
+ * Set/clear one flag(bit: 0-31)
+ * A single bit-band store, so it needs no critical section even in ISRs.
+ *
+ * フラグを一つセット／クリアします（bit: 0-31）
+ * ビットバンドの一回のストアなので、ISRでもクリティカルセクションは要りません
+ */
+void yevent_flags_set_bit(struct yevent_flags *ev, uint8_t bit);
+void yevent_flags_clear_bit(struct yevent_flags *ev, uint8_t bit);
+
+/*
+ * Set/clear the flags in bits, can be called from ISRs
+ *
+ * bitsにあるフラグをセット／クリアします、ISRから呼び出せます
+ */
+void yevent_flags_set(struct yevent_flags *ev, uint32_t bits);
+void yevent_flags_clear(struct yevent_flags *ev, uint32_t bits);
+
+uint32_t yevent_flags_get(struct yevent_flags *ev);
+
+/*
+ * Wait until any(or all, with YEVENT_WAIT_ALL) of the bits are set,
+ * for at most timeout_ms(0 for not waiting, YOS_WAIT_FOREVER for no timeout).
+ * Return the satisfied bits, or 0 if timed out.
+ * Do not call this from ISRs.
+ *
+ * bitsのいずれか（YEVENT_WAIT_ALLの場合すべて）がセットされるまで
+ * 最大timeout_msの間待ちます（0は待たない、YOS_WAIT_FOREVERはタイムアウトなし）
+ * 満たされたビットを戻ります、タイムアウトした場合0を戻ります
+ * ISRから呼び出さないでください
+ */
+uint32_t yevent_flags_wait(struct yevent_flags *ev, uint32_t bits,
+							uint8_t options, uint16_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
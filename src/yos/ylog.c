@@ -0,0 +1,252 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "yos.h"
+#include "yatomic.h"
+#include "ylog.h"
+
+#define _YLOG_BUFFER_MASK				(YLOG_BUFFER_SIZE_WORD - 1)
+
+#define _YLOG_NOTIFY_FLUSH				(1UL << 0)
+
+/*
+ * Bytes of a record on the wire at most
+ *
+ * 送信時のレコードの最大バイト数
+ */
+#define _YLOG_RECORD_MAX_BYTE			(1 + 4 + 5 * YLOG_MAX_ARG_COUNT)
+#define _YLOG_SEND_BUFFER_SIZE_BYTE		64
+
+/*
+ * Provided by the linker for the "ylog_fmt" section. Weak, as the section
+ * is not there if no YLOG() is used, then both are NULL and the table
+ * is empty(ylog_write() rejects every fmt).
+ *
+ * "ylog_fmt"セクションのためにリンカーが用意します。YLOG()を使わない場合
+ * セクションはありませんので弱いシンボルにします。その場合両方NULLで、
+ * テーブルは空です（ylog_write()はすべてのfmtを拒否します）
+ */
+extern const char __start_ylog_fmt[] __attribute__((weak));
+extern const char __stop_ylog_fmt[] __attribute__((weak));
+
+/*
+ * Records are written words [head, head + n) reserved by a CAS on head,
+ * header word last, and read from tail by the only reader. A slot whose
+ * header is not valid yet is still being written, the reader stops there.
+ * Indexes run freely and are masked to access the buffer.
+ *
+ * レコードはheadへのCASで確保したワード[head, head + n)に、ヘッダーワードを最後に
+ * 書き込まれ、唯一の読み手によってtailから読まれます。ヘッダーがまだ有効でない
+ * スロットは書き込み中ですので、読み手はそこで止まります
+ * インデックスは自由に増え、マスクしてバッファにアクセスします
+ */
+static volatile uint32_t _ylog_buffer[YLOG_BUFFER_SIZE_WORD];
+static volatile uint32_t _ylog_head = 0;
+static volatile uint32_t _ylog_tail = 0;
+static volatile uint32_t _ylog_dropped = 0;
+static volatile uint32_t _ylog_flushing = 0;
+static uint32_t _ylog_dropped_reported = 0;
+static volatile int _ylog_task_id = -1;
+static struct basic_io_port *volatile _ylog_port = NULL;
+
+int ylog_write(const char *fmt, int arg_count, ...)
+{
+	/*
+	 * The id is the offset of fmt in the section, it must fit in
+	 * the header and must not be YLOG_ID_DROPPED
+	 *
+	 * idはセクション内のfmtのオフセットですので、ヘッダーに収まり、
+	 * YLOG_ID_DROPPEDでない必要があります
+	 */
+	if (fmt < __start_ylog_fmt || fmt >= __stop_ylog_fmt
+		|| (uint32_t)(fmt - __start_ylog_fmt) >= YLOG_ID_DROPPED
+		|| arg_count < 0 || arg_count > YLOG_MAX_ARG_COUNT) {
+		return -1;
+	}
+
+	uint32_t n = 1 + (uint32_t)arg_count;
+	uint32_t head;
+	uint32_t used;
+	do {
+		head = _ylog_head;
+		used = head - _ylog_tail;
+		if (used + n > YLOG_BUFFER_SIZE_WORD) {
+			yatomic_fetch_add32(&_ylog_dropped, 1);
+			return -1;
+		}
+	} while (!yatomic_cas32(&_ylog_head, head, head + n));
+
+	va_list ap;
+	va_start(ap, arg_count);
+	uint32_t i = 1;
+	while (i < n) {
+		_ylog_buffer[(head + i) & _YLOG_BUFFER_MASK] = va_arg(ap, uint32_t);
+		i++;
+	}
+	va_end(ap);
+
+	_ylog_buffer[head & _YLOG_BUFFER_MASK] = YLOG_HEADER_VALID
+			| ((uint32_t)arg_count << YLOG_HEADER_ARGC_SHIFT)
+			| ((yos_get_ticks() & YLOG_HEADER_TICKS_MASK) << YLOG_HEADER_TICKS_SHIFT)
+			| ((uint32_t)(fmt - __start_ylog_fmt) & YLOG_HEADER_ID_MASK);
+
+	/*
+	 * Wake the task only when the buffer gets half full, so that a burst
+	 * of logs does not send a notification each
+	 *
+	 * バッファが半分埋まった時のみタスクを起こし、連続したログがそれぞれ
+	 * 通知を送らないようにします
+	 */
+	if (used < YLOG_BUFFER_SIZE_WORD / 2 && used + n >= YLOG_BUFFER_SIZE_WORD / 2
+		&& _ylog_task_id >= 0) {
+		yos_task_notify(_ylog_task_id, _YLOG_NOTIFY_FLUSH);
+	}
+
+	return 0;
+}
+
+void ylog_set_port(struct basic_io_port *port)
+{
+	_ylog_port = port;
+}
+
+static uint16_t _ylog_encode_u32(uint8_t *buf, uint32_t value)
+{
+	uint16_t len = 0;
+	while (value >= 0x80) {
+		buf[len++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	buf[len++] = (uint8_t)value;
+
+	return len;
+}
+
+static uint16_t _ylog_encode_header(uint8_t *buf, uint32_t header)
+{
+	buf[0] = YLOG_SYNC_BYTE;
+	buf[1] = (uint8_t)header;
+	buf[2] = (uint8_t)(header >> 8);
+	buf[3] = (uint8_t)(header >> 16);
+	buf[4] = (uint8_t)(header >> 24);
+
+	return 5;
+}
+
+int ylog_flush(void)
+{
+	/*
+	 * Only one flusher at a time, as it is the only reader of the buffer
+	 *
+	 * バッファの唯一の読み手ですので、同時にフラッシュするのは一つのみです
+	 */
+	if (!yatomic_cas32(&_ylog_flushing, 0, 1)) {
+		return 0;
+	}
+
+	uint8_t buf[_YLOG_SEND_BUFFER_SIZE_BYTE];
+	uint16_t len = 0;
+	int count = 0;
+	uint32_t tail = _ylog_tail;
+	uint32_t head;
+	uint32_t header;
+	uint32_t arg_count;
+	uint32_t i;
+	uint32_t dropped = _ylog_dropped;
+
+	if (dropped != _ylog_dropped_reported) {
+		len += _ylog_encode_header(buf + len, YLOG_HEADER_VALID
+					| (1UL << YLOG_HEADER_ARGC_SHIFT)
+					| ((yos_get_ticks() & YLOG_HEADER_TICKS_MASK) << YLOG_HEADER_TICKS_SHIFT)
+					| YLOG_ID_DROPPED);
+		len += _ylog_encode_u32(buf + len, dropped - _ylog_dropped_reported);
+		_ylog_dropped_reported = dropped;
+	}
+
+	while ((head = _ylog_head) != tail) {
+		header = _ylog_buffer[tail & _YLOG_BUFFER_MASK];
+		if ((header & YLOG_HEADER_VALID) == 0) {
+			break;
+		}
+
+		/*
+		 * A valid header is written after its arguments, so the whole record
+		 * is before head. If not, the buffer is broken, drop up to head
+		 * rather than reading past it.
+		 *
+		 * 有効なヘッダーは引数の後に書き込まれるので、レコード全体はheadより前にあります
+		 * そうでない場合はバッファが壊れていますので、headを越えて読まずにheadまで捨てます
+		 */
+		arg_count = (header >> YLOG_HEADER_ARGC_SHIFT) & YLOG_HEADER_ARGC_MASK;
+		if (arg_count > YLOG_MAX_ARG_COUNT || head - tail < 1 + arg_count) {
+			while (tail != head) {
+				_ylog_buffer[tail & _YLOG_BUFFER_MASK] = 0;
+				tail++;
+			}
+			_ylog_tail = tail;
+			yatomic_fetch_add32(&_ylog_dropped, 1);
+			break;
+		}
+
+		if (len + _YLOG_RECORD_MAX_BYTE > sizeof(buf)) {
+			basic_io_write(_ylog_port, (char *)buf, len, 1);
+			len = 0;
+		}
+
+		len += _ylog_encode_header(buf + len, header);
+		i = 1;
+		while (i <= arg_count) {
+			len += _ylog_encode_u32(buf + len, _ylog_buffer[(tail + i) & _YLOG_BUFFER_MASK]);
+			i++;
+		}
+
+		/*
+		 * All the words of the record are cleared before the slots are
+		 * given back to writers, so that a stale argument never looks
+		 * like a valid header later
+		 *
+		 * スロットを書き手に返す前にレコードのすべてのワードをクリアし、
+		 * 古い引数が後で有効なヘッダーに見えないようにします
+		 */
+		i = 0;
+		while (i <= arg_count) {
+			_ylog_buffer[(tail + i) & _YLOG_BUFFER_MASK] = 0;
+			i++;
+		}
+		tail += 1 + arg_count;
+		_ylog_tail = tail;
+		count++;
+	}
+
+	if (len > 0) {
+		basic_io_write(_ylog_port, (char *)buf, len, 1);
+	}
+
+	_ylog_flushing = 0;
+
+	return count;
+}
+
+int ylog_task(void *data)
+{
+	_ylog_task_id = yos_get_current_task_id();
+
+	while (1) {
+		ylog_flush();
+		yos_task_notify_wait(_YLOG_NOTIFY_FLUSH, YLOG_FLUSH_INTERVAL_MS);
+	}
+
+	return 0;
+}
+
+uint32_t ylog_get_dropped_count(void)
+{
+	return _ylog_dropped;
+}
@@ -0,0 +1,159 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#ifndef _Y_LOG_H_
+#define _Y_LOG_H_
+
+#include <stdint.h>
+#include "../../lib/cmdline/basic_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Deferred binary logging
+ *
+ * YLOG() records only the id of the format string and the raw arguments
+ * into a lock-free buffer, it can be called from tasks and ISRs.
+ * ylog_task() ships the records to a port in binary, and
+ * tools/ylog_decode.py expands them on the host with the format strings
+ * taken from the ELF file.
+ *
+ * Format strings are placed in the "ylog_fmt" section, the id is the offset
+ * in it. Arguments are up to YLOG_MAX_ARG_COUNT 32 bit values(ints, pointers),
+ * formatted like yfmt(see lib/yfmt/yfmt.h). %s only works with constant
+ * strings in flash, as the host looks them up in the ELF file. A string
+ * in RAM is shown as its address, e.g. the task name YOS_DBG() logs in
+ * yos_create_task() with YOS_DEBUG_MSG_OUTPUT 2.
+ *
+ * 遅延バイナリログ
+ *
+ * YLOG()はフォーマット文字列のidと生の引数のみをロックフリーのバッファに記録します
+ * タスクとISRから呼び出せます
+ * ylog_task()はレコードをバイナリでポートに送り、tools/ylog_decode.pyは
+ * ELFファイルから取ったフォーマット文字列でホスト側で展開します
+ *
+ * フォーマット文字列は"ylog_fmt"セクションに置かれ、idはその中のオフセットです
+ * 引数は最大YLOG_MAX_ARG_COUNT個の32ビット値（整数、ポインタ）で、yfmtのように
+ * フォーマットされます（lib/yfmt/yfmt.hを参照）。ホストはELFファイルから
+ * 探しますので、%sはフラッシュにある定数文字列のみ使えます。RAMにある文字列は
+ * アドレスとして表示されます（例：YOS_DEBUG_MSG_OUTPUTが2の場合に
+ * yos_create_task()でYOS_DBG()がログするタスク名）
+ */
+
+/*
+ * Buffer size in 32 bit words, must be power of 2
+ * A record takes 1 + argument count words.
+ *
+ * バッファのサイズ（32ビットワード単位）、2の冪である必要があります
+ * レコード一つは1 + 引数の数ワードを使います
+ */
+#define YLOG_BUFFER_SIZE_WORD			128
+#define YLOG_MAX_ARG_COUNT				8
+
+/*
+ * ylog_task() ships records at least this often, or as soon as
+ * the buffer is half full
+ *
+ * ylog_task()は少なくともこの間隔で、またはバッファが半分埋まったらすぐに
+ * レコードを送ります
+ */
+#define YLOG_FLUSH_INTERVAL_MS			100
+
+/*
+ * Record header, as stored in the buffer and sent on the wire
+ * bit 31: valid, bit 30-27: argument count, bit 26-16: low 11 bits of ticks,
+ * bit 15-0: id
+ *
+ * バッファに保存され、送られるレコードヘッダー
+ * ビット31：有効、ビット30-27：引数の数、ビット26-16：tickの下位11ビット、
+ * ビット15-0：id
+ */
+#define YLOG_HEADER_VALID				(1UL << 31)
+#define YLOG_HEADER_ARGC_SHIFT			27
+#define YLOG_HEADER_ARGC_MASK			0x0F
+#define YLOG_HEADER_TICKS_SHIFT			16
+#define YLOG_HEADER_TICKS_MASK			0x07FF
+#define YLOG_HEADER_ID_MASK				0xFFFF
+
+/*
+ * Id of the record sent by ylog_task() when records have been dropped
+ * by a full buffer, the argument is the count dropped
+ *
+ * バッファが満杯でレコードが捨てられた時にylog_task()が送るレコードのid
+ * 引数は捨てた数です
+ */
+#define YLOG_ID_DROPPED					0xFFFF
+
+/*
+ * On the wire a record is the sync byte, the header(4 bytes, little endian)
+ * and the arguments, each in unsigned LEB128(1 to 5 bytes).
+ *
+ * 送信時のレコードは同期バイト、ヘッダー（4バイト、リトルエンディアン）と
+ * 引数（それぞれ符号なしLEB128で1～5バイト）です
+ */
+#define YLOG_SYNC_BYTE					0xA5
+
+#define _YLOG_NARG(...)					_YLOG_NARG_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define _YLOG_NARG_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...)		n
+
+/*
+ * Log fmt with the arguments, fmt must be a string literal
+ *
+ * fmtを引数と一緒にログします、fmtは文字列リテラルである必要があります
+ */
+#define YLOG(fmt, ...)																	\
+	do {																				\
+		static const char _ylog_fmt[] __attribute__((section("ylog_fmt"), used)) = fmt;	\
+		ylog_write(_ylog_fmt, _YLOG_NARG(__VA_ARGS__), ##__VA_ARGS__);					\
+	} while (0)
+
+/*
+ * Record a log, usually called by YLOG()
+ * Return 0 if recorded, or -1 if the buffer is full(the record is dropped)
+ * or on error
+ *
+ * ログを記録します、通常YLOG()から呼び出されます
+ * 記録した場合0を、バッファが満杯（レコードは捨てられます）またはエラーの場合-1を戻ります
+ */
+int ylog_write(const char *fmt, int arg_count, ...);
+
+/*
+ * Set the port records are shipped to, NULL for the console
+ *
+ * レコードを送るポートを設定します、NULLはコンソール
+ */
+void ylog_set_port(struct basic_io_port *port);
+
+/*
+ * Ship all the recorded logs to the port
+ * Return the count of records shipped
+ *
+ * 記録されたログをすべてポートに送ります
+ * 送ったレコードの数を戻ります
+ */
+int ylog_flush(void);
+
+/*
+ * Task function shipping records in background, give it to yos_create_task()
+ *
+ * バックグラウンドでレコードを送るタスク関数、yos_create_task()に渡します
+ */
+int ylog_task(void *data);
+
+/*
+ * Count of records dropped by a full buffer by now
+ *
+ * 今までにバッファが満杯で捨てられたレコードの数
+ */
+uint32_t ylog_get_dropped_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
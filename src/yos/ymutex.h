@@ -16,10 +16,40 @@ extern "C" {
 
 struct ymutex {
 	volatile int owner;
+	/*
+	 * How many times the owner has locked it(recursive mutex only)
+	 *
+	 * 所有者がロックした回数（再帰mutexのみ）
+	 */
+	uint16_t lock_count;
+	uint8_t is_recursive;
+	/*
+	 * Bit [task id] is set while the task is waiting for the mutex
+	 *
+	 * mutexを待っているタスクのビット[タスクid]がセットされます
+	 */
+	volatile uint32_t waiters;
 };
 
+/*
+ * Return value of ymutex_lock_timeout() when timed out
+ *
+ * タイムアウトした時のymutex_lock_timeout()の戻り値
+ */
+#define YMUTEX_RET_TIMEOUT			-2
+
 void ymutex_init(struct ymutex *mutex);
 
+/*
+ * Init a recursive mutex
+ * The owner can lock it again, and it is released when unlocked
+ * as many times as locked.
+ *
+ * 再帰mutexを初期化します
+ * 所有者は再びロックでき、ロックした回数と同じだけアンロックすると解放されます
+ */
+void ymutex_init_recursive(struct ymutex *mutex);
+
 /*
  * Deinit mutex
  * Note that this will get the mutex first(means may block the current task)
@@ -41,6 +71,20 @@ void ymutex_deinit(struct ymutex *mutex);
  */
 void ymutex_lock(struct ymutex *mutex);
 
+/*
+ * Block until got mutex, for at most timeout_ms
+ * (YOS_WAIT_FOREVER for no timeout).
+ * The task sleeps while waiting and is woken up when the mutex is released.
+ * Return 0 if got mutex, YMUTEX_RET_TIMEOUT if timed out, or -1 on error
+ *
+ * mutexを取得するまで最大timeout_msの間ブロックされます
+ * （タイムアウトなしはYOS_WAIT_FOREVER）
+ * 待っている間タスクは寝ていて、mutexが解放されると起こされます
+ * 取得できた場合0を、タイムアウトした場合YMUTEX_RET_TIMEOUTを、
+ * エラーの場合-1を戻ります
+ */
+int ymutex_lock_timeout(struct ymutex *mutex, uint16_t timeout_ms);
+
 /*
  * Try to get mutex
  * Return 0 if got mutex, or other value returns
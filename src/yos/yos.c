@@ -12,20 +12,89 @@
 #include <libopencm3/stm32/rcc.h>
 #include <stdarg.h>
 #include <stdint.h>
-#include <stdio.h>
 #include <string.h>
 #include "yos_core.h"
 #include "ystack.h"
 #include "ymutex.h"
+#include "yatomic.h"
+#include "ybitband.h"
 #include "common_def.h"
+#include "../../lib/yfmt/yfmt.h"
 
 static struct yos_task _all_tasks[YOS_MAX_TASK_COUNT];
 static void *volatile stack_bp_for_next_task;
 static volatile int task_id_for_next;
 
 static volatile int _CURRENT_TASK_ID;
+static int _idle_task_id = -1;
 static struct yos_task *volatile _CURRENT_TASK = NULL;
 static volatile uint32_t _tmp_sp;
+static volatile uint32_t _yos_ticks;
+static volatile uint32_t _yos_switch_count;
+
+/*
+ * Bit [task id] is set while the task is runnable, it is written through
+ * the bit-band alias so that a single task can be updated from tasks and
+ * ISRs without a read-modify-write race.
+ *
+ * 動けるタスクのビット[タスクid]がセットされます。ビットバンドのエイリアス
+ * 経由で書き込みますので、タスクからもISRからも読み込み・変更・書き込みの
+ * 競合なしで一つのタスクを更新できます
+ */
+static volatile uint32_t _ready_bitmap;
+
+/*
+ * Bit [task id] is set while the task is waiting for notifications
+ *
+ * 通知を待っているタスクのビット[タスクid]がセットされます
+ */
+static volatile uint32_t _notify_waiters;
+
+/*
+ * Bit [task id] is set in the entry of the task's priority
+ *
+ * タスクの優先度のエントリーにビット[タスクid]がセットされます
+ */
+static volatile uint32_t _priority_masks[YOS_TASK_PRIORITY_LEVELS];
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+/*
+ * Pass of the task picked last time, a task becoming runnable again
+ * starts from here so that it cannot take back the time it slept.
+ *
+ * 前回選ばれたタスクのパス値、再び動けるようになったタスクはここから始まります
+ * 寝ていた時間分を取り戻せないようにするためです
+ */
+static uint32_t _stride_global_pass;
+
+/*
+ * Non-zero if scheduling is caused by the current task giving up the CPU
+ *
+ * 今のタスクがCPUを放棄したことでスケジュールする場合、0以外になります
+ */
+static volatile int _is_sched_by_yield;
+#endif
+
+static void _task_update_ready(struct yos_task *task)
+{
+	int runnable = (task->status == YOS_TASK_STATUS_CREATED
+					|| task->status == YOS_TASK_STATUS_RUNNING);
+#if (YOS_TASK_CPU_BUDGET == 1)
+	if (task->is_throttled) {
+		runnable = 0;
+	}
+#endif
+	if (task->is_suspended) {
+		runnable = 0;
+	}
+
+	ybitband_write(&_ready_bitmap, (uint8_t)(task - _all_tasks), runnable);
+}
+
+static void _task_set_status(struct yos_task *task, enum yos_task_status status)
+{
+	task->status = status;
+	_task_update_ready(task);
+}
 
 /*
  * Task shell function
@@ -42,10 +111,10 @@ static void _yos_task_shell(int task_id)
 	struct yos_task *task = _all_tasks + task_id;
 	int task_ret = -1;
 	if (task->task_func != NULL) {
-		task->status = YOS_TASK_STATUS_RUNNING;
+		_task_set_status(task, YOS_TASK_STATUS_RUNNING);
 		task_ret = task->task_func(task->data);
 	}
-	task->status = YOS_TASK_STATUS_EXITED;
+	_task_set_status(task, YOS_TASK_STATUS_EXITED);
 
 resched:
 	schedule();
@@ -99,32 +168,196 @@ static void _yos_init_task_stack(int task_id, struct yos_task *task)
 }
 
 /*
- * Find the next runnable task one by one.
+ * Runnable tasks of the highest priority, the scheduling policy picks
+ * one of them
+ *
+ * 一番高い優先度の動けるタスク、スケジューリングポリシーはその中から一つ選びます
+ */
+static uint32_t _get_ready_candidates(void)
+{
+	uint32_t ready = _ready_bitmap;
+	uint32_t candidates;
+	int priority = YOS_TASK_PRIORITY_LEVELS - 1;
+	while (priority > 0) {
+		candidates = ready & _priority_masks[priority];
+		if (candidates != 0) {
+			return candidates;
+		}
+
+		priority--;
+	}
+
+	return ready;
+}
+
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_RR)
+/*
+ * Find the next runnable task after the current one in the ready bitmap,
+ * wrapping around to the lowest one(the current task included).
  *
- * 順番に次の実行できるタスクを探します
+ * レディービットマップで今のタスクの次の動けるタスクを探します
+ * なければ一番小さいもの（今のタスクを含む）に戻ります
+ */
+static int _find_next_task_to_run(void)
+{
+	uint32_t ready = _get_ready_candidates();
+	uint32_t ready_after_current;
+	if (ready == 0) {
+		return _CURRENT_TASK_ID;
+	}
+
+	ready_after_current = ready & ~((2UL << _CURRENT_TASK_ID) - 1);
+	if (ready_after_current != 0) {
+		/*
+		 * Found!
+		 *
+		 * 見つけた！
+		 */
+		return __builtin_ctz(ready_after_current);
+	}
+
+	return __builtin_ctz(ready);
+}
+#elif (YOS_SCHED_POLICY == YOS_SCHED_POLICY_EDF)
+/*
+ * Find the runnable task with the earliest absolute deadline.
+ * Tasks are checked in round-robin order starting from the next one and
+ * ending with the current one, so that tasks with the same deadline, and
+ * tasks without deadline, take turns.
+ *
+ * 絶対デッドラインの一番早い動けるタスクを探します
+ * 次のタスクから順番にチェックし、最後に今のタスクをチェックします。
+ * そのため、デッドラインが同じタスク同士、またデッドラインのないタスク同士は
+ * 順番に動きます
  */
 static int _find_next_task_to_run(void)
 {
 	struct yos_task *_the_next_task;
-	int the_next_task_id = (_CURRENT_TASK_ID + 1) % YOS_MAX_TASK_COUNT;
-	while (the_next_task_id != _CURRENT_TASK_ID) {
+	struct yos_task *_best_task = NULL;
+	int best_task_id = _CURRENT_TASK_ID;
+	int the_next_task_id = _CURRENT_TASK_ID;
+	uint32_t candidates = _get_ready_candidates();
+	int i = 0;
+	while (i < YOS_MAX_TASK_COUNT) {
+		the_next_task_id = (the_next_task_id + 1) % YOS_MAX_TASK_COUNT;
 		_the_next_task = _all_tasks + the_next_task_id;
-		if (_the_next_task->status == YOS_TASK_STATUS_CREATED
-			|| _the_next_task->status == YOS_TASK_STATUS_RUNNING) {
-			/*
-			 * Found!
-			 *
-			 * 見つけた！
-			 */
-			break;
-		} else if (_the_next_task->status == YOS_TASK_STATUS_EXITED) {
-			_the_next_task->status = YOS_TASK_STATUS_INVALID;
+		if (candidates & (1UL << the_next_task_id)) {
+			if (_best_task == NULL) {
+				_best_task = _the_next_task;
+				best_task_id = the_next_task_id;
+			} else if (_the_next_task->period_ticks > 0) {
+				if (_best_task->period_ticks == 0
+					|| (int32_t)(_the_next_task->abs_deadline - _best_task->abs_deadline) < 0) {
+					_best_task = _the_next_task;
+					best_task_id = the_next_task_id;
+				}
+			}
 		}
 
+		i++;
+	}
+
+	return best_task_id;
+}
+#elif (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+/*
+ * Find the runnable task with the minimum pass, the idle task is picked
+ * only if there is no other runnable task. A task giving up the CPU is
+ * treated the same way, since its pass has not been advanced yet.
+ * Tasks are checked in round-robin order starting from the next one, so
+ * that tasks with the same pass take turns.
+ *
+ * パス値の一番小さい動けるタスクを探します、アイドルタスクは他に動けるタスクが
+ * ない場合のみ選ばれます。CPUを放棄したタスクも同じように扱います、まだパス値が
+ * 進んでいないためです
+ * 次のタスクから順番にチェックしますので、パス値が同じタスク同士は順番に動きます
+ */
+static int _find_next_task_to_run(void)
+{
+	struct yos_task *_the_next_task;
+	struct yos_task *_best_task = NULL;
+	int best_task_id = _idle_task_id;
+	int the_next_task_id = _CURRENT_TASK_ID;
+	uint32_t candidates = _get_ready_candidates();
+	int i = 0;
+	while (i < YOS_MAX_TASK_COUNT) {
 		the_next_task_id = (the_next_task_id + 1) % YOS_MAX_TASK_COUNT;
+		_the_next_task = _all_tasks + the_next_task_id;
+		if (the_next_task_id != _idle_task_id
+			&& !(_is_sched_by_yield && the_next_task_id == _CURRENT_TASK_ID)
+			&& (candidates & (1UL << the_next_task_id))) {
+			if (_best_task == NULL
+				|| (int32_t)(_the_next_task->pass - _best_task->pass) < 0) {
+				_best_task = _the_next_task;
+				best_task_id = the_next_task_id;
+			}
+		}
+
+		i++;
+	}
+
+	if (_best_task != NULL) {
+		_stride_global_pass = _best_task->pass;
+	} else if (_is_sched_by_yield && _CURRENT_TASK_ID != _idle_task_id
+		&& (candidates & (1UL << _CURRENT_TASK_ID))) {
+		best_task_id = _CURRENT_TASK_ID;
+	}
+
+	return best_task_id;
+}
+#endif
+
+/*
+ * Charge the tick to the task running when it comes
+ *
+ * tickが来た時に動いているタスクにそのtickを課金します
+ */
+static void _account_current_task_irq(void)
+{
+	struct yos_task *_the_task = _CURRENT_TASK;
+
+#if (YOS_RECORD_CPU_USAGE == 1)
+	_the_task->run_ticks++;
+#endif
+
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+	_the_task->pass += _the_task->stride;
+#endif
+
+#if (YOS_TASK_CPU_BUDGET == 1)
+	if (_the_task->budget_ticks > 0 && !(_the_task->is_throttled)) {
+		if (_the_task->budget_used_ticks == 0) {
+			_the_task->replenish_tick = _yos_ticks + _the_task->budget_period_ticks;
+		}
+		_the_task->budget_used_ticks++;
+		if (_the_task->budget_used_ticks >= _the_task->budget_ticks) {
+			_the_task->is_throttled = 1;
+			_the_task->throttle_count++;
+			_task_update_ready(_the_task);
+		}
 	}
+#endif
+}
 
-	return the_next_task_id;
+/*
+ * Make a waiting task runnable again
+ *
+ * 待っているタスクを再び動けるようにします
+ */
+static void _task_catch_up_pass(struct yos_task *task)
+{
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+	if ((int32_t)(task->pass - _stride_global_pass) < 0) {
+		task->pass = _stride_global_pass;
+	}
+#endif
+}
+
+static void _task_wake_irq(struct yos_task *task)
+{
+	task->block_ticks = 0;
+	_task_set_status(task, YOS_TASK_STATUS_RUNNING);
+	_task_catch_up_pass(task);
 }
 
 static void _update_task_block_ticks_irq(void)
@@ -134,14 +367,28 @@ static void _update_task_block_ticks_irq(void)
 	while (i < YOS_MAX_TASK_COUNT) {
 		_the_task = _all_tasks + i;
 		if (_the_task->status == YOS_TASK_STATUS_WAITING) {
-			if (_the_task->block_ticks > 0) {
-				_the_task->block_ticks--;
-			}
-			if (_the_task->block_ticks == 0) {
-				_the_task->status = YOS_TASK_STATUS_RUNNING;
+			if (_the_task->block_ticks != YOS_WAIT_FOREVER) {
+				if (_the_task->block_ticks > 0) {
+					_the_task->block_ticks--;
+				}
+				if (_the_task->block_ticks == 0) {
+					_task_wake_irq(_the_task);
+				}
 			}
+		} else if (_the_task->status == YOS_TASK_STATUS_EXITED
+			&& i != _CURRENT_TASK_ID) {
+			_task_set_status(_the_task, YOS_TASK_STATUS_INVALID);
 		}
 
+#if (YOS_TASK_CPU_BUDGET == 1)
+		if (_the_task->budget_used_ticks > 0
+			&& (int32_t)(_yos_ticks - _the_task->replenish_tick) >= 0) {
+			_the_task->budget_used_ticks = 0;
+			_the_task->is_throttled = 0;
+			_task_update_ready(_the_task);
+		}
+#endif
+
 		i++;
 	}
 }
@@ -197,6 +444,10 @@ static void _make_pendsv(void)
 	SCB_ICSR |= SCB_ICSR_PENDSVSET;
 }
 
+#if (YOS_PREEMPTION == 1)
+static volatile int _sched_switch_pending;
+#endif
+
 static volatile int next_task_id;
 static struct yos_task *volatile next_task;
 static volatile int is_systick_trigger_by_int = 1;
@@ -204,8 +455,39 @@ static volatile int is_systick_trigger_by_int = 1;
 void sys_tick_handler(void)
 {
 	if (is_systick_trigger_by_int) {
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+		_is_sched_by_yield = 0;
+#endif
+		_yos_ticks++;
+		_account_current_task_irq();
 		_update_task_block_ticks_irq();
+
+#if (YOS_PREEMPTION == 1)
+		if (_CURRENT_TASK->sched_lock_nesting > 0
+			&& _CURRENT_TASK->status == YOS_TASK_STATUS_RUNNING) {
+			/*
+			 * Scheduler locked, switch when unlocked
+			 *
+			 * スケジューラーはロックされているので、アンロック時に切り替えます
+			 */
+			_sched_switch_pending = 1;
+			return;
+		}
+#else
+		if (_CURRENT_TASK_ID != _idle_task_id
+			&& _CURRENT_TASK->status == YOS_TASK_STATUS_RUNNING) {
+			/*
+			 * Cooperative only, the current task runs until it yields
+			 *
+			 * 協調のみ、今のタスクは自発的に放棄するまで動きます
+			 */
+			return;
+		}
+#endif
 	} else {
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+		_is_sched_by_yield = 1;
+#endif
 		is_systick_trigger_by_int = 1;
 	}
 
@@ -223,7 +505,7 @@ void sys_tick_handler(void)
 			_yos_init_task_stack(next_task_id, next_task);
 		} else if (next_task->status == YOS_TASK_STATUS_RUNNING) {
 		} else if (next_task->status == YOS_TASK_STATUS_EXITED) {
-			next_task->status = YOS_TASK_STATUS_INVALID;
+			_task_set_status(next_task, YOS_TASK_STATUS_INVALID);
 			/*
 			 * Invalid task
 			 *
@@ -273,6 +555,7 @@ __attribute__((naked)) void pend_sv_handler(void)
 	_CURRENT_TASK = next_task;
 	_CURRENT_TASK_ID = next_task_id;
 	_CURRENT_TASK->status = YOS_TASK_STATUS_RUNNING;
+	_yos_switch_count++;
 
 	RESTORE_LR_FROM_STACK
 
@@ -316,12 +599,39 @@ int yos_create_task(int (*task_func)(void *task_data), void *data,
 	this_task->min_sp_by_now = this_task->sp;
 #endif
 	this_task->stack_size = stack_size;
-	this_task->status = YOS_TASK_STATUS_CREATED;
 	this_task->block_ticks = 0;
+	this_task->wake_reason = YOS_WAKE_REASON_TIMEOUT;
+	this_task->notify_bits = 0;
+	this_task->sched_lock_nesting = 0;
+	this_task->is_suspended = 0;
+	this_task->priority = YOS_TASK_PRIORITY_DEFAULT;
+	ybitband_set(&(_priority_masks[YOS_TASK_PRIORITY_DEFAULT]), (uint8_t)task_id);
+#if (YOS_RECORD_CPU_USAGE == 1)
+	this_task->run_ticks = 0;
+#endif
+#if (YOS_TASK_CPU_BUDGET == 1)
+	this_task->budget_ticks = 0;
+	this_task->budget_period_ticks = 0;
+	this_task->budget_used_ticks = 0;
+	this_task->throttle_count = 0;
+	this_task->is_throttled = 0;
+#endif
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+	this_task->tickets = YOS_STRIDE_DEFAULT_TICKETS;
+	this_task->stride = _STRIDE_ONE / YOS_STRIDE_DEFAULT_TICKETS;
+	this_task->pass = _stride_global_pass;
+#endif
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_EDF)
+	this_task->period_ticks = 0;
+	this_task->rel_deadline_ticks = 0;
+	this_task->deadline_miss_count = 0;
+	memset(this_task->lateness_hist, 0x00, sizeof(this_task->lateness_hist));
+#endif
+	_task_set_status(this_task, YOS_TASK_STATUS_CREATED);
 	if (name != NULL) {
 		strncpy(this_task->name, name, sizeof(this_task->name));
 	} else {
-		snprintf(this_task->name, sizeof(this_task->name), "Tsk%03d", task_id);
+		yfmt_snprintf(this_task->name, sizeof(this_task->name), "Tsk%03d", task_id);
 	}
 	this_task->name[sizeof(this_task->name) - 1] = '\0';
 
@@ -386,11 +696,16 @@ void yos_init(void)
 
 		i++;
 	}
+	_ready_bitmap = 0;
+	_notify_waiters = 0;
+	memset((void *)_priority_masks, 0x00, sizeof(_priority_masks));
 
 	_CURRENT_TASK_ID = yos_create_task(_yos_idle_task,
 										NULL,
 										YOS_IDLE_TASK_STACK_SIZE,
 										YOS_IDLE_TASK_NAME);
+	_idle_task_id = _CURRENT_TASK_ID;
+	yos_task_set_priority(_idle_task_id, 0);
 
 	YOS_DBG("yos_create_task returned %d\n", _CURRENT_TASK_ID);
 }
@@ -404,13 +719,19 @@ void yos_start(void)
 	}
 
 	yos_clock_setup();
+
+	/*
+	 * The first tick shall not come before the current task is set
+	 *
+	 * 今のタスクを設定する前に最初のtickが来ないようにします
+	 */
+	cm_disable_interrupts();
 	if (_global_timer_init() != 0) {
+		cm_enable_interrupts();
 		YOS_DBG("global timer init failed\n");
 		return;
 	}
 
-	cm_disable_interrupts();
-
 	_CURRENT_TASK_ID = first_task_id;
 	_CURRENT_TASK = _all_tasks + first_task_id;
 
@@ -455,16 +776,95 @@ static void _schedule_irq(void)
 
 void yos_task_delay(uint16_t ticks)
 {
+	/*
+	 * YOS_WAIT_FOREVER as block ticks means no timeout, so a delay
+	 * of that many ticks is one tick shorter
+	 *
+	 * ブロックtickとしてのYOS_WAIT_FOREVERはタイムアウトなしを意味しますので、
+	 * そのtick数の遅延は1tick短くなります
+	 */
+	if (ticks == YOS_WAIT_FOREVER) {
+		ticks = YOS_WAIT_FOREVER - 1;
+	}
+
 	cm_disable_interrupts();
-	_CURRENT_TASK->status = YOS_TASK_STATUS_WAITING;
+	yos_task_block_irq(ticks);
+	cm_enable_interrupts();
+}
+
+/*
+ * Switch at once to a task just made runnable, if it should run before
+ * the current one, instead of letting it wait for the next tick
+ *
+ * 動けるようになったばかりのタスクが今のタスクより先に動くべき場合、
+ * 次のtickまで待たせずにすぐ切り替えます
+ */
+static void _schedule_for_task_irq(struct yos_task *task)
+{
+	if (_CURRENT_TASK == NULL) {
+		return;
+	}
+
+	if (_CURRENT_TASK_ID == _idle_task_id) {
+		_schedule_irq();
+		return;
+	}
+
+#if (YOS_PREEMPTION == 1)
+	if (task->priority > _CURRENT_TASK->priority) {
+		if (_CURRENT_TASK->sched_lock_nesting > 0) {
+			_sched_switch_pending = 1;
+		} else {
+			_schedule_irq();
+		}
+	}
+#endif
+}
+
+void yos_task_block_irq(uint16_t ticks)
+{
+	_CURRENT_TASK->wake_reason = YOS_WAKE_REASON_TIMEOUT;
 	_CURRENT_TASK->block_ticks = ticks;
+	_task_set_status(_CURRENT_TASK, YOS_TASK_STATUS_WAITING);
 	_schedule_irq();
-	cm_enable_interrupts();
+}
+
+void yos_task_wake_irq(int task_id)
+{
+	if (task_id < 0 || task_id >= YOS_MAX_TASK_COUNT) {
+		return;
+	}
+
+	struct yos_task *this_task = _all_tasks + task_id;
+	if (this_task->status != YOS_TASK_STATUS_WAITING) {
+		return;
+	}
+
+	this_task->wake_reason = YOS_WAKE_REASON_SIGNALED;
+	_task_wake_irq(this_task);
+	_schedule_for_task_irq(this_task);
+}
+
+void yos_task_wake_waiters_irq(volatile uint32_t *waiters)
+{
+	uint32_t pending = *waiters;
+	int task_id;
+	while (pending != 0) {
+		task_id = __builtin_ctz(pending);
+		pending &= pending - 1;
+		ybitband_clear(waiters, (uint8_t)task_id);
+		yos_task_wake_irq(task_id);
+	}
+}
+
+int yos_task_get_wake_reason(void)
+{
+	return _CURRENT_TASK->wake_reason;
 }
 
 void yos_task_msleep(uint16_t ms)
 {
-	yos_task_delay(ms < _TASK_SWITCH_INTERVAL_MS ? 1 : ms / _TASK_SWITCH_INTERVAL_MS);
+	yos_task_delay(_MS_TO_TICKS(ms));
 }
 
 #define DEBUG_SCHEDULE_WITH_DELAY	0
@@ -479,10 +879,363 @@ void schedule(void)
 #endif
 }
 
+void yos_sched_lock(void)
+{
+#if (YOS_PREEMPTION == 1)
+	if (_CURRENT_TASK == NULL) {
+		return;
+	}
+
+	_CURRENT_TASK->sched_lock_nesting++;
+#endif
+}
+
+void yos_sched_unlock(void)
+{
+#if (YOS_PREEMPTION == 1)
+	struct yos_task *this_task = _CURRENT_TASK;
+	if (this_task == NULL || this_task->sched_lock_nesting == 0) {
+		return;
+	}
 
-int yos_get_task_info(int task_id, struct yos_task_info *task_info)
+	this_task->sched_lock_nesting--;
+	if (this_task->sched_lock_nesting == 0 && _sched_switch_pending) {
+		_sched_switch_pending = 0;
+		schedule();
+	}
+#endif
+}
+
+int yos_task_suspend(int task_id)
+{
+	if (task_id < 0 || task_id >= YOS_MAX_TASK_COUNT || task_id == _idle_task_id) {
+		return -1;
+	}
+
+	int ret = -1;
+	struct yos_task *this_task = _all_tasks + task_id;
+	uint32_t primask = cm_mask_interrupts(1);
+	if (this_task->status != YOS_TASK_STATUS_INVALID
+		&& this_task->status != YOS_TASK_STATUS_EXITED) {
+		this_task->is_suspended = 1;
+		_task_update_ready(this_task);
+		if (task_id == _CURRENT_TASK_ID && _CURRENT_TASK != NULL) {
+			_schedule_irq();
+		}
+		ret = 0;
+	}
+	cm_mask_interrupts(primask);
+
+	return ret;
+}
+
+int yos_task_resume_from_isr(int task_id)
+{
+	if (task_id < 0 || task_id >= YOS_MAX_TASK_COUNT) {
+		return -1;
+	}
+
+	int ret = -1;
+	struct yos_task *this_task = _all_tasks + task_id;
+	uint32_t primask = cm_mask_interrupts(1);
+	if (this_task->status != YOS_TASK_STATUS_INVALID) {
+		if (this_task->is_suspended) {
+			this_task->is_suspended = 0;
+			_task_update_ready(this_task);
+			_task_catch_up_pass(this_task);
+			_schedule_for_task_irq(this_task);
+		}
+		ret = 0;
+	}
+	cm_mask_interrupts(primask);
+
+	return ret;
+}
+
+int yos_task_resume(int task_id)
+{
+	return yos_task_resume_from_isr(task_id);
+}
+
+int yos_task_set_priority(int task_id, uint8_t priority)
+{
+	if (task_id < 0 || task_id >= YOS_MAX_TASK_COUNT
+		|| priority >= YOS_TASK_PRIORITY_LEVELS
+		|| (task_id == _idle_task_id && priority != 0)) {
+		return -1;
+	}
+
+	int ret = -1;
+	struct yos_task *this_task = _all_tasks + task_id;
+	uint32_t primask = cm_mask_interrupts(1);
+	if (this_task->status != YOS_TASK_STATUS_INVALID) {
+		ybitband_clear(&(_priority_masks[this_task->priority]), (uint8_t)task_id);
+		ybitband_set(&(_priority_masks[priority]), (uint8_t)task_id);
+		this_task->priority = priority;
+		if (task_id != _CURRENT_TASK_ID) {
+			_schedule_for_task_irq(this_task);
+		} else if (_CURRENT_TASK != NULL
+			&& !(_get_ready_candidates() & (1UL << task_id))) {
+			/*
+			 * Lowered below another runnable task
+			 *
+			 * 他の動けるタスクより低くなりました
+			 */
+			_schedule_irq();
+		}
+		ret = 0;
+	}
+	cm_mask_interrupts(primask);
+
+	return ret;
+}
+
+uint32_t yos_get_switch_count(void)
+{
+	return _yos_switch_count;
+}
+
+uint32_t yos_get_ticks(void)
+{
+	return _yos_ticks;
+}
+
+int yos_is_started(void)
+{
+	return (_CURRENT_TASK != NULL);
+}
+
+int yos_in_isr(void)
+{
+	uint32_t ipsr;
+	__asm__ __volatile__ (
+		"mrs %0, ipsr"
+		: "=r"(ipsr)
+		:
+		:
+	);
+
+	return ipsr != 0;
+}
+
+int yos_get_current_task_id(void)
+{
+	return _CURRENT_TASK_ID;
+}
+
+uint32_t yos_task_get_stack_left(void)
+{
+	if (_CURRENT_TASK == NULL) {
+		return 0;
+	}
+
+	uint32_t sp;
+	__asm__ __volatile__ (
+		"mov %0, sp"
+		: "=r"(sp)
+		:
+		:
+	);
+
+	uint32_t stack_end = (uint32_t)(_CURRENT_TASK->bp) - _CURRENT_TASK->stack_size;
+	if (sp <= stack_end) {
+		return 0;
+	}
+
+	return sp - stack_end;
+}
+
+int yos_task_notify(int task_id, uint32_t bits)
+{
+	if (task_id < 0 || task_id >= YOS_MAX_TASK_COUNT) {
+		return -1;
+	}
+
+	struct yos_task *this_task = _all_tasks + task_id;
+	if (this_task->status == YOS_TASK_STATUS_INVALID) {
+		return -1;
+	}
+
+	/*
+	 * Bits are set before checking the waiter, and the waiter checks bits
+	 * and registers itself with interrupts disabled, so no wake-up is lost.
+	 *
+	 * 待ち手のチェックより前にビットをセットし、待ち手はビットのチェックと
+	 * 自分の登録を割り込み禁止の状態で行いますので、起床が失われることはありません
+	 */
+	yatomic_set_bits32(&(this_task->notify_bits), bits);
+	if (ybitband_get(&_notify_waiters, (uint8_t)task_id)) {
+		uint32_t primask = cm_mask_interrupts(1);
+		ybitband_clear(&_notify_waiters, (uint8_t)task_id);
+		yos_task_wake_irq(task_id);
+		cm_mask_interrupts(primask);
+	}
+
+	return 0;
+}
+
+uint32_t yos_task_notify_take_irq(uint32_t bits)
+{
+	uint32_t got = _CURRENT_TASK->notify_bits & bits;
+	if (got != 0) {
+		yatomic_clear_bits32(&(_CURRENT_TASK->notify_bits), got);
+	}
+
+	return got;
+}
+
+void yos_task_notify_set_waiting_irq(int is_waiting)
+{
+	ybitband_write(&_notify_waiters, (uint8_t)_CURRENT_TASK_ID, is_waiting);
+}
+
+uint32_t yos_task_notify_wait(uint32_t bits, uint16_t timeout_ms)
+{
+	uint32_t got = 0;
+	uint32_t deadline = _yos_ticks + _MS_TO_TICKS(timeout_ms);
+	int32_t remaining_ticks;
+	while (1) {
+		cm_disable_interrupts();
+		got = yos_task_notify_take_irq(bits);
+		remaining_ticks = yos_wait_ticks_left(timeout_ms, deadline);
+		if (got != 0 || remaining_ticks <= 0) {
+			yos_task_notify_set_waiting_irq(0);
+			cm_enable_interrupts();
+			break;
+		}
+
+		yos_task_notify_set_waiting_irq(1);
+		yos_task_block_irq((uint16_t)remaining_ticks);
+		cm_enable_interrupts();
+	}
+
+	return got;
+}
+
+#if (YOS_TASK_CPU_BUDGET == 1)
+int yos_task_set_budget(int task_id, uint16_t budget_ms, uint16_t period_ms)
+{
+	if (task_id < 0 || task_id >= YOS_MAX_TASK_COUNT || task_id == _idle_task_id) {
+		return -1;
+	}
+
+	if (budget_ms > 0 && period_ms < budget_ms) {
+		return -1;
+	}
+
+	int ret = -1;
+	struct yos_task *this_task = _all_tasks + task_id;
+	cm_disable_interrupts();
+	if (this_task->status != YOS_TASK_STATUS_INVALID) {
+		if (budget_ms == 0) {
+			this_task->budget_ticks = 0;
+			this_task->budget_period_ticks = 0;
+		} else {
+			this_task->budget_ticks = _MS_TO_TICKS(budget_ms);
+			this_task->budget_period_ticks = _MS_TO_TICKS(period_ms);
+		}
+		this_task->budget_used_ticks = 0;
+		this_task->is_throttled = 0;
+		_task_update_ready(this_task);
+		ret = 0;
+	}
+	cm_enable_interrupts();
+
+	return ret;
+}
+#endif
+
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+int yos_task_set_tickets(int task_id, uint16_t tickets)
+{
+	if (task_id < 0 || task_id >= YOS_MAX_TASK_COUNT || tickets == 0) {
+		return -1;
+	}
+
+	int ret = -1;
+	struct yos_task *this_task = _all_tasks + task_id;
+	cm_disable_interrupts();
+	if (this_task->status != YOS_TASK_STATUS_INVALID) {
+		this_task->tickets = tickets;
+		this_task->stride = _STRIDE_ONE / tickets;
+		ret = 0;
+	}
+	cm_enable_interrupts();
+
+	return ret;
+}
+#endif
+
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_EDF)
+int yos_task_set_deadline(int task_id, uint16_t period_ms, uint16_t deadline_ms)
+{
+	if (task_id < 0 || task_id >= YOS_MAX_TASK_COUNT) {
+		return -1;
+	}
+
+	int ret = -1;
+	struct yos_task *this_task = _all_tasks + task_id;
+	cm_disable_interrupts();
+	if (this_task->status != YOS_TASK_STATUS_INVALID) {
+		if (period_ms == 0) {
+			this_task->period_ticks = 0;
+			this_task->rel_deadline_ticks = 0;
+		} else {
+			this_task->period_ticks = _MS_TO_TICKS(period_ms);
+			this_task->rel_deadline_ticks = _MS_TO_TICKS(deadline_ms);
+			this_task->release_tick = _yos_ticks;
+			this_task->abs_deadline = this_task->release_tick + this_task->rel_deadline_ticks;
+		}
+		ret = 0;
+	}
+	cm_enable_interrupts();
+
+	return ret;
+}
+
+static const uint32_t _lateness_bucket_bounds[YOS_EDF_LATENESS_BUCKETS] = YOS_EDF_LATENESS_BUCKET_BOUNDS;
+
+void yos_task_wait_next_period(void)
 {
 	cm_disable_interrupts();
+	struct yos_task *this_task = _CURRENT_TASK;
+	if (this_task->period_ticks > 0) {
+		int32_t lateness = (int32_t)(_yos_ticks - this_task->abs_deadline);
+		int i = 0;
+		if (lateness > 0) {
+			this_task->deadline_miss_count++;
+			while (i < YOS_EDF_LATENESS_BUCKETS - 1
+				&& (uint32_t)lateness > _lateness_bucket_bounds[i]) {
+				i++;
+			}
+		}
+		this_task->lateness_hist[i]++;
+
+		this_task->release_tick += this_task->period_ticks;
+		if ((int32_t)(_yos_ticks - this_task->release_tick) >= this_task->period_ticks) {
+			/*
+			 * More than one period behind, skip the missed releases
+			 *
+			 * 一周期以上遅れているので、逃したリリースを飛ばします
+			 */
+			this_task->release_tick = _yos_ticks;
+		}
+		this_task->abs_deadline = this_task->release_tick + this_task->rel_deadline_ticks;
+
+		int32_t wait_ticks = (int32_t)(this_task->release_tick - _yos_ticks);
+		if (wait_ticks > 0) {
+			this_task->block_ticks = wait_ticks;
+			_task_set_status(this_task, YOS_TASK_STATUS_WAITING);
+		}
+	}
+	_schedule_irq();
+	cm_enable_interrupts();
+}
+#endif
+
+int yos_get_task_info(int task_id, struct yos_task_info *task_info)
+{
+	yos_sched_lock();
 
 	int ret = -1;
 	if (task_id < 0 || task_id >= YOS_MAX_TASK_COUNT) {
@@ -496,7 +1249,9 @@ int yos_get_task_info(int task_id, struct yos_task_info *task_info)
 		|| this_task->status == YOS_TASK_STATUS_EXITED) {
 		if (task_info != NULL) {
 			task_info->id = task_id;
-			task_info->status = this_task->status;
+			task_info->status = this_task->is_suspended ?
+									YOS_TASK_STATUS_SUSPENDED : this_task->status;
+			task_info->priority = this_task->priority;
 			task_info->stack_size = this_task->stack_size;
 #if (YOS_RECORD_STACK_USAGE == 1)
 			task_info->stack_max_reached_size =
@@ -505,6 +1260,25 @@ int yos_get_task_info(int task_id, struct yos_task_info *task_info)
 			task_info->stack_max_reached_size = 0;
 #endif
 			strcpy(task_info->name, this_task->name);
+#if (YOS_RECORD_CPU_USAGE == 1)
+			task_info->run_ticks = this_task->run_ticks;
+#endif
+#if (YOS_TASK_CPU_BUDGET == 1)
+			task_info->budget_ms = this_task->budget_ticks * _TASK_SWITCH_INTERVAL_MS;
+			task_info->budget_period_ms = this_task->budget_period_ticks * _TASK_SWITCH_INTERVAL_MS;
+			task_info->throttle_count = this_task->throttle_count;
+			task_info->is_throttled = this_task->is_throttled;
+#endif
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+			task_info->tickets = this_task->tickets;
+#endif
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_EDF)
+			task_info->period_ms = this_task->period_ticks * _TASK_SWITCH_INTERVAL_MS;
+			task_info->deadline_ms = this_task->rel_deadline_ticks * _TASK_SWITCH_INTERVAL_MS;
+			task_info->deadline_miss_count = this_task->deadline_miss_count;
+			memcpy(task_info->lateness_hist, this_task->lateness_hist,
+					sizeof(task_info->lateness_hist));
+#endif
 		}
 
 		ret = 0;
@@ -513,7 +1287,7 @@ int yos_get_task_info(int task_id, struct yos_task_info *task_info)
 	}
 
 para_err:
-	cm_enable_interrupts();
+	yos_sched_unlock();
 
 	return ret;
 }
@@ -521,13 +1295,26 @@ para_err:
 
 #define _YMUTEX_OWNER_NONE		-1
 
-void ymutex_init(struct ymutex *mutex)
+static void _ymutex_init(struct ymutex *mutex, uint8_t is_recursive)
 {
 	if (mutex == NULL) {
 		return;
 	}
 
 	mutex->owner = _YMUTEX_OWNER_NONE;
+	mutex->lock_count = 0;
+	mutex->is_recursive = is_recursive;
+	mutex->waiters = 0;
+}
+
+void ymutex_init(struct ymutex *mutex)
+{
+	_ymutex_init(mutex, 0);
+}
+
+void ymutex_init_recursive(struct ymutex *mutex)
+{
+	_ymutex_init(mutex, 1);
 }
 
 void ymutex_deinit(struct ymutex *mutex)
@@ -536,21 +1323,58 @@ void ymutex_deinit(struct ymutex *mutex)
 		return;
 	}
 	ymutex_lock(mutex);
+	mutex->lock_count = 0;
 	mutex->owner = _YMUTEX_OWNER_NONE;
 }
 
 void ymutex_lock(struct ymutex *mutex)
+{
+	ymutex_lock_timeout(mutex, YOS_WAIT_FOREVER);
+}
+
+int ymutex_lock_timeout(struct ymutex *mutex, uint16_t timeout_ms)
 {
 	if (mutex == NULL) {
-		return;
+		return -1;
 	}
 
+	if (ymutex_try_lock(mutex) == 0) {
+		return 0;
+	}
+
+	int ret = -1;
+	uint32_t deadline = _yos_ticks + _MS_TO_TICKS(timeout_ms);
+	int32_t remaining_ticks;
 	while (1) {
+		cm_disable_interrupts();
+		/*
+		 * Try again and register as a waiter with interrupts disabled,
+		 * so a release in between cannot be missed.
+		 *
+		 * 割り込み禁止の状態で再試行して待ち手として登録しますので、
+		 * その間の解放を見逃すことはありません
+		 */
 		if (ymutex_try_lock(mutex) == 0) {
+			ybitband_clear(&(mutex->waiters), (uint8_t)_CURRENT_TASK_ID);
+			cm_enable_interrupts();
+			ret = 0;
 			break;
 		}
-		schedule();
+
+		remaining_ticks = yos_wait_ticks_left(timeout_ms, deadline);
+		if (remaining_ticks <= 0) {
+			ybitband_clear(&(mutex->waiters), (uint8_t)_CURRENT_TASK_ID);
+			cm_enable_interrupts();
+			ret = YMUTEX_RET_TIMEOUT;
+			break;
+		}
+
+		ybitband_set(&(mutex->waiters), (uint8_t)_CURRENT_TASK_ID);
+		yos_task_block_irq((uint16_t)remaining_ticks);
+		cm_enable_interrupts();
 	}
+
+	return ret;
 }
 
 int ymutex_try_lock(struct ymutex *mutex)
@@ -560,12 +1384,20 @@ int ymutex_try_lock(struct ymutex *mutex)
 		return ret;
 	}
 
-	cm_disable_interrupts();
-	if (mutex->owner < 0) {
-		mutex->owner = _CURRENT_TASK_ID;
+	if (yatomic_cas32((volatile uint32_t *)&(mutex->owner),
+					(uint32_t)_YMUTEX_OWNER_NONE, (uint32_t)_CURRENT_TASK_ID)) {
+		mutex->lock_count = 1;
+		ret = 0;
+	} else if (mutex->is_recursive && mutex->owner == _CURRENT_TASK_ID
+		&& mutex->lock_count < 0xFFFF) {
+		/*
+		 * Only the owner itself changes lock_count
+		 *
+		 * lock_countを変更するのは所有者自身のみです
+		 */
+		mutex->lock_count++;
 		ret = 0;
 	}
-	cm_enable_interrupts();
 
 	return ret;
 }
@@ -573,16 +1405,33 @@ int ymutex_try_lock(struct ymutex *mutex)
 int ymutex_unlock(struct ymutex *mutex)
 {
 	int ret = -1;
-	if (mutex == NULL) {
+	if (mutex == NULL || mutex->owner != _CURRENT_TASK_ID) {
 		return ret;
 	}
 
-	cm_disable_interrupts();
-	if (mutex->owner == _CURRENT_TASK_ID) {
-		mutex->owner = _YMUTEX_OWNER_NONE;
+	if (mutex->lock_count > 1) {
+		mutex->lock_count--;
+		return 0;
+	}
+
+	mutex->lock_count = 0;
+	if (yatomic_cas32((volatile uint32_t *)&(mutex->owner),
+					(uint32_t)_CURRENT_TASK_ID, (uint32_t)_YMUTEX_OWNER_NONE)) {
 		ret = 0;
 	}
-	cm_enable_interrupts();
+
+	if (ret == 0 && mutex->waiters != 0) {
+		/*
+		 * Wake up all the waiters and let them try again,
+		 * a waiter that has timed out in between is not missed then.
+		 *
+		 * 待ち手をすべて起こして再試行させます
+		 * そうすると、その間にタイムアウトした待ち手で取りこぼすことはありません
+		 */
+		uint32_t primask = cm_mask_interrupts(1);
+		yos_task_wake_waiters_irq(&(mutex->waiters));
+		cm_mask_interrupts(primask);
+	}
 
 	return ret;
 }
@@ -14,12 +14,92 @@
 extern "C" {
 #endif
 
+/*
+ * Debug messages: 0 for none, 1 for text by basic_io_printf(),
+ * 2 for binary by YLOG()(see ylog.h)
+ *
+ * デバッグメッセージ：0はなし、1はbasic_io_printf()によるテキスト、
+ * 2はYLOG()によるバイナリ（ylog.hを参照）
+ */
 #define YOS_DEBUG_MSG_OUTPUT		0
 
 #define YOS_RECORD_STACK_USAGE		1
 
+/*
+ * Count ticks each task has run
+ *
+ * タスクごとに動いたtick数を数えます
+ */
+#define YOS_RECORD_CPU_USAGE		1
+
+/*
+ * Per-task CPU budget(see yos_task_set_budget)
+ *
+ * タスクごとのCPU予算（yos_task_set_budgetを参照）
+ */
+#define YOS_TASK_CPU_BUDGET			1
+
 #define YOS_TICK_HZ					100
 
+/*
+ * Preemption
+ * 1:		Tasks are switched by time slice as well as at yield and block points
+ * 0:		Cooperative only, tasks are switched only when they yield or block
+ *			(e.g. schedule(), yos_task_msleep(), waiting for a mutex).
+ *			SysTick only does time accounting, except that the idle task
+ *			is still switched away by it once another task becomes runnable.
+ *			A task shall never busy loop without yielding in this mode.
+ *
+ * プリエンプション
+ * 1:		タイムスライスでも、自発的な放棄やブロックでもタスクを切り替えます
+ * 0:		協調のみ、タスクは自発的に放棄またはブロックする時だけ切り替えます
+ *			（例：schedule()、yos_task_msleep()、mutexの待ち合わせ）
+ *			SysTickは時間の計算のみ行います。ただし、他のタスクが動けるように
+ *			なったら、アイドルタスクからは切り替えます。
+ *			このモードでは、タスクは放棄せずにビジーループしてはいけません
+ */
+#define YOS_PREEMPTION				1
+
+/*
+ * Scheduling policy, selected at build time
+ *
+ * YOS_SCHED_POLICY_RR:
+ *   Round-robin by time slice among all runnable tasks
+ *
+ * YOS_SCHED_POLICY_EDF:
+ *   Earliest deadline first. Tasks which have declared a period and a
+ *   relative deadline by yos_task_set_deadline() run before the others,
+ *   and the one with the earliest absolute deadline is picked.
+ *   Tasks without a deadline(e.g. the idle task) share the rest of the
+ *   CPU by round-robin.
+ *
+ * YOS_SCHED_POLICY_STRIDE:
+ *   Proportional share by stride scheduling. Each task holds tickets
+ *   (see yos_task_set_tickets), and gets the CPU in proportion to them.
+ *   The idle task runs only when no other task is runnable.
+ *
+ * スケジューリングポリシー、ビルド時に選択します
+ *
+ * YOS_SCHED_POLICY_RR:
+ *   すべての動けるタスクをタイムスライスで順番に動かせます
+ *
+ * YOS_SCHED_POLICY_EDF:
+ *   デッドラインの早い順（EDF）。yos_task_set_deadline()で周期と相対デッドラインを
+ *   宣言したタスクは他のタスクより先に動き、絶対デッドラインの一番早いタスクが
+ *   選ばれます。
+ *   デッドラインのないタスク（例えばアイドルタスク）は残りのCPUを順番に使います。
+ *
+ * YOS_SCHED_POLICY_STRIDE:
+ *   ストライドスケジューリングによる比例配分。各タスクはチケットを持ち
+ *   （yos_task_set_ticketsを参照）、チケットの比率でCPUを使います。
+ *   アイドルタスクは他に動けるタスクがない場合のみ動きます。
+ */
+#define YOS_SCHED_POLICY_RR			0
+#define YOS_SCHED_POLICY_EDF		1
+#define YOS_SCHED_POLICY_STRIDE		2
+
+#define YOS_SCHED_POLICY			YOS_SCHED_POLICY_RR
+
 /*
  * Maxium length of a task name, terminating '\0' character included
  *
@@ -34,6 +114,18 @@ extern "C" {
  */
 #define YOS_MAX_TASK_COUNT			8
 
+/*
+ * Task priorities, 0(lowest) to YOS_TASK_PRIORITY_LEVELS - 1(highest).
+ * Only the runnable tasks of the highest priority are given to the
+ * scheduling policy. The idle task is always at 0.
+ *
+ * タスクの優先度、0（最低）からYOS_TASK_PRIORITY_LEVELS - 1（最高）まで
+ * 一番高い優先度の動けるタスクのみがスケジューリングポリシーに渡されます
+ * アイドルタスクはいつも0です
+ */
+#define YOS_TASK_PRIORITY_LEVELS	4
+#define YOS_TASK_PRIORITY_DEFAULT	1
+
 #define U16_HIGH_BYTE(u16)		((uint8_t)(((uint16_t)(u16)) >> 8))
 #define U16_LOW_BYTE(u16)		((uint8_t)(((uint16_t)(u16)) & 0xFF))
 #define U8HL_TO_U16(u8h, u8l)	((uint16_t)((((uint16_t)(u8h)) << 8) | (uint8_t)(u8l)))
@@ -110,7 +202,18 @@ enum yos_task_status {
 	 * タスク関数は戻ったが関連するリソースはまだ回収されていません
 	 * （まだ実現していません）
 	 */
-	YOS_TASK_STATUS_EXITED
+	YOS_TASK_STATUS_EXITED,
+
+	/*
+	 * Task is suspended by yos_task_suspend() and does not run until
+	 * yos_task_resume() is called, whatever it was doing before
+	 * (Reported by yos_get_task_info() only)
+	 *
+	 * タスクはyos_task_suspend()で一時停止され、yos_task_resume()を呼び出すまで
+	 * 以前何をしていても動きません
+	 * （yos_get_task_info()でのみ報告されます）
+	 */
+	YOS_TASK_STATUS_SUSPENDED
 };
 
 /*
@@ -167,8 +270,10 @@ void yos_start(void);
 
 /*
  * Delay current task for specified ticks
+ * (at most YOS_WAIT_FOREVER - 1, a longer delay is cut to it)
  *
  * タスクを指定するtickの間に待ち合わせます
+ * （最大YOS_WAIT_FOREVER - 1、それより長い遅延は切り詰められます）
  */
 void yos_task_delay(uint16_t ticks);
 
@@ -190,6 +295,32 @@ void yos_task_delay(uint16_t ticks);
  */
 void yos_task_msleep(uint16_t ms);
 
+/*
+ * Suspend a task(the current one included) until it is resumed, the
+ * idle task cannot be suspended. A waiting task keeps counting down its
+ * wait while suspended.
+ * yos_task_resume_from_isr() is the same as yos_task_resume() but can
+ * be called from ISRs.
+ * Return 0 if done, or -1
+ *
+ * タスク（今のタスクを含む）を再開されるまで一時停止します、アイドルタスクは
+ * 一時停止できません。待ち合わせ中のタスクは一時停止中も待ち時間を数え続けます
+ * yos_task_resume_from_isr()はyos_task_resume()と同じですが、ISRから呼び出せます
+ * できた場合0を、その他は-1を戻ります
+ */
+int yos_task_suspend(int task_id);
+int yos_task_resume(int task_id);
+int yos_task_resume_from_isr(int task_id);
+
+/*
+ * Change the priority of a task(0 to YOS_TASK_PRIORITY_LEVELS - 1)
+ * Return 0 if done, or -1
+ *
+ * タスクの優先度を変更します（0からYOS_TASK_PRIORITY_LEVELS - 1まで）
+ * できた場合0を、その他は-1を戻ります
+ */
+int yos_task_set_priority(int task_id, uint8_t priority);
+
 /*
  * Give up the current executing chance
  *
@@ -197,13 +328,224 @@ void yos_task_msleep(uint16_t ms);
  */
 void schedule(void);
 
+/*
+ * Lock/unlock the scheduler
+ *
+ * While locked, the current task will not be preempted by other tasks,
+ * but interrupts still come as usual. A task switch requested by a tick
+ * in the locked region happens when unlocked. Calls can be nested, and
+ * the scheduler is unlocked by the last yos_sched_unlock().
+ *
+ * This is cheaper than masking interrupts when only other tasks need to
+ * be kept out, but it does not protect data shared with ISRs.
+ * Do not sleep or wait in the locked region, since other tasks will be
+ * run then.
+ * With YOS_PREEMPTION 0, tasks are never preempted and these do nothing.
+ *
+ * スケジューラーをロック／アンロックします
+ *
+ * ロック中、今のタスクは他のタスクに割り込まれませんが、割り込みは普段通り
+ * に来ます。ロック中にtickで要求されたタスク切り替えはアンロック時に行います。
+ * 入れ子で呼び出すことができ、最後のyos_sched_unlock()でアンロックされます
+ *
+ * 他のタスクだけを締め出したい場合、割り込みをマスクするより軽いですが、
+ * ISRと共有するデータは保護できません。
+ * ロック中に寝たり待ち合わせたりしないでください、その時は他のタスクが動きます
+ * YOS_PREEMPTIONが0の場合、タスクは割り込まれないので、これらは何もしません
+ */
+void yos_sched_lock(void);
+void yos_sched_unlock(void);
+
+/*
+ * Get how many times tasks have been switched since yos_start() is called
+ *
+ * yos_start()を呼び出してからタスクを切り替えた回数を取得します
+ */
+uint32_t yos_get_switch_count(void);
+
+/*
+ * Get ticks elapsed since yos_start() is called
+ *
+ * yos_start()を呼び出してから経ったtick数を取得します
+ */
+uint32_t yos_get_ticks(void);
+
+/*
+ * Return non-zero if yos_start() has been called and tasks are running
+ *
+ * yos_start()が呼び出されてタスクが動いている場合、0以外を戻ります
+ */
+int yos_is_started(void);
+
+/*
+ * Return non-zero if called in an ISR(handler mode)
+ * yos_is_started() is true there as well, but the caller is not a task
+ * and must not sleep or wait.
+ *
+ * ISR（ハンドラモード）で呼び出された場合0以外を戻ります
+ * そこでもyos_is_started()は真ですが、呼び出し元はタスクではなく、
+ * 寝たり待ち合わせたりしてはいけません
+ */
+int yos_in_isr(void);
+
+/*
+ * Get the id of the task calling this
+ *
+ * これを呼び出したタスクのidを取得します
+ */
+int yos_get_current_task_id(void);
+
+/*
+ * Get the stack bytes left below the current SP of the task calling this,
+ * or 0 if yos is not started
+ *
+ * これを呼び出したタスクの現在のSPより下に残っているスタックのバイト数を取得します
+ * yosが開始していない場合0を戻ります
+ */
+uint32_t yos_task_get_stack_left(void);
+
+/*
+ * Timeout value of wait functions meaning to wait forever
+ *
+ * 待ち合わせ関数のタイムアウト値、永遠に待つことを意味します
+ */
+#define YOS_WAIT_FOREVER			0xFFFF
+
+/*
+ * Task notification
+ *
+ * Every task has 32 notification bits. yos_task_notify() sets bits of a
+ * task and wakes it up if it is waiting for them, it can be called from
+ * ISRs. yos_task_notify_wait() waits until any of the bits are set for at
+ * most timeout_ms(0 for not waiting, YOS_WAIT_FOREVER for no timeout), and
+ * returns the bits got(cleared then), or 0 if timed out.
+ *
+ * タスク通知
+ *
+ * 各タスクは32個の通知ビットを持っています。yos_task_notify()はタスクのビットを
+ * セットして、それを待っている場合は起こします、ISRから呼び出せます。
+ * yos_task_notify_wait()はbitsのいずれかがセットされるまで最大timeout_msの間
+ * 待ちます（0は待たない、YOS_WAIT_FOREVERはタイムアウトなし）、取得したビット
+ * （その時クリアされます）を戻ります、タイムアウトした場合0を戻ります
+ */
+int yos_task_notify(int task_id, uint32_t bits);
+uint32_t yos_task_notify_wait(uint32_t bits, uint16_t timeout_ms);
+
+#if (YOS_TASK_CPU_BUDGET == 1)
+/*
+ * Limit a task to run at most budget_ms within period_ms.
+ *
+ * The budget is consumed by the ticks the task runs. The period starts
+ * when the task begins to consume a full budget, and the budget is
+ * replenished when the period is over(like a sporadic server with one
+ * replenishment). A task which has used up its budget is throttled, i.e.
+ * not scheduled, until the replenishment, and the event is counted.
+ *
+ * Setting budget_ms to 0 removes the limit. The idle task cannot be limited.
+ *
+ * Return 0 if ok, or other value means error.
+ *
+ * タスクをperiod_msの間に最大budget_msしか動かないように制限します
+ *
+ * 予算はタスクが動いたtickで消費されます。周期は満タンの予算を消費し始めた時から
+ * 始まり、周期が終わったら予算は補充されます（補充一回のスポラディックサーバー
+ * のように）。予算を使い切ったタスクは補充されるまでスケジュールされなくなり、
+ * その回数は数えられます。
+ *
+ * budget_msを0にすると、制限はなくなります。アイドルタスクは制限できません
+ *
+ * 0を戻る場合、設定できました
+ * その他の値を戻る場合、エラーになります
+ */
+int yos_task_set_budget(int task_id, uint16_t budget_ms, uint16_t period_ms);
+#endif
+
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+/*
+ * Tickets given to a task when it is created
+ *
+ * タスク作成時のチケット数
+ */
+#define YOS_STRIDE_DEFAULT_TICKETS		100
+
+/*
+ * Set tickets of a task, the CPU is shared among runnable tasks in
+ * proportion to their tickets. tickets shall not be 0.
+ *
+ * Return 0 if ok, or other value means error.
+ *
+ * タスクのチケット数を設定します、CPUは動けるタスクの間にチケットの比率で
+ * 分けられます。ticketsは0にしてはいけません
+ *
+ * 0を戻る場合、設定できました
+ * その他の値を戻る場合、エラーになります
+ */
+int yos_task_set_tickets(int task_id, uint16_t tickets);
+#endif
+
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_EDF)
+/*
+ * Buckets of the lateness histogram, a job finished after its deadline
+ * by N ticks is counted in the first bucket whose bound is not less than N.
+ *
+ * 遅延ヒストグラムのバケット、デッドラインよりNtick遅れて終わったジョブは
+ * 上限がN以上の最初のバケットに数えられます
+ */
+#define YOS_EDF_LATENESS_BUCKETS			4
+#define YOS_EDF_LATENESS_BUCKET_BOUNDS		{0, 1, 4, 0xFFFFFFFF}
+
+/*
+ * Declare the current job timing of a task, period_ms and deadline_ms are
+ * relative to the release time of each job. The first job is released now.
+ * Setting period_ms to 0 makes the task a task without deadline again.
+ *
+ * Return 0 if ok, or other value means error.
+ *
+ * タスクのジョブタイミングを宣言します。period_msとdeadline_msは各ジョブの
+ * リリース時刻からの相対値です。最初のジョブは今リリースされます。
+ * period_msを0にすると、デッドラインのないタスクに戻ります。
+ *
+ * 0を戻る場合、設定できました
+ * その他の値を戻る場合、エラーになります
+ */
+int yos_task_set_deadline(int task_id, uint16_t period_ms, uint16_t deadline_ms);
+
+/*
+ * Finish the current job and wait until the next one is released.
+ * Deadline miss and lateness of the finished job are recorded.
+ *
+ * 今のジョブを終わらせて、次のジョブがリリースされるまで待ち合わせます
+ * 終わったジョブのデッドラインミスと遅延は記録されます
+ */
+void yos_task_wait_next_period(void);
+#endif
+
 
 struct yos_task_info {
 	int id;
 	enum yos_task_status status;
+	uint8_t priority;
 	uint16_t stack_size;
 	uint16_t stack_max_reached_size;
 	char name[YOS_TASK_NAME_MAX_LENGTH];
+#if (YOS_RECORD_CPU_USAGE == 1)
+	uint32_t run_ticks;
+#endif
+#if (YOS_TASK_CPU_BUDGET == 1)
+	uint16_t budget_ms;
+	uint16_t budget_period_ms;
+	uint16_t throttle_count;
+	uint8_t is_throttled;
+#endif
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+	uint16_t tickets;
+#endif
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_EDF)
+	uint16_t period_ms;
+	uint16_t deadline_ms;
+	uint16_t deadline_miss_count;
+	uint16_t lateness_hist[YOS_EDF_LATENESS_BUCKETS];
+#endif
 };
 
 /*
@@ -222,7 +564,10 @@ int yos_get_task_info(int task_id, struct yos_task_info *task_info);
 
 #if (YOS_DEBUG_MSG_OUTPUT == 1)
 #include "../../lib/cmdline/basic_io.h"
-#define YOS_DBG(...)		basic_io_printf("[YOS]"__VA_ARGS__)
+#define YOS_DBG(...)		basic_io_printf(NULL, "[YOS]"__VA_ARGS__)
+#elif (YOS_DEBUG_MSG_OUTPUT == 2)
+#include "ylog.h"
+#define YOS_DBG(fmt, ...)	YLOG("[YOS]"fmt, ##__VA_ARGS__)
 #else
 #define YOS_DBG(...)
 #endif
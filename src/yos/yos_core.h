@@ -20,6 +20,34 @@ extern "C" {
 #endif
 
 #define _TASK_SWITCH_INTERVAL_MS		(1000 / YOS_TICK_HZ)
+#define _MS_TO_TICKS(ms)				((ms) < _TASK_SWITCH_INTERVAL_MS ? 1 : (ms) / _TASK_SWITCH_INTERVAL_MS)
+
+#if (YOS_SCHED_POLICY != YOS_SCHED_POLICY_RR \
+	&& YOS_SCHED_POLICY != YOS_SCHED_POLICY_EDF \
+	&& YOS_SCHED_POLICY != YOS_SCHED_POLICY_STRIDE)
+#error "Unknown YOS_SCHED_POLICY!"
+#endif
+
+/*
+ * Runnable tasks are kept in a 32-bit bitmap
+ *
+ * 動けるタスクは32ビットのビットマップで管理されます
+ */
+#if (YOS_MAX_TASK_COUNT > 31)
+#error "YOS_MAX_TASK_COUNT cannot exceed 31!"
+#endif
+
+#if (YOS_TASK_PRIORITY_LEVELS < 1 \
+	|| YOS_TASK_PRIORITY_DEFAULT >= YOS_TASK_PRIORITY_LEVELS)
+#error "Wrong YOS_TASK_PRIORITY_LEVELS or YOS_TASK_PRIORITY_DEFAULT!"
+#endif
+
+/*
+ * The pass of a task advances by _STRIDE_ONE / tickets for each tick it runs
+ *
+ * タスクのパス値は動いたtickごとに _STRIDE_ONE / tickets ずつ進みます
+ */
+#define _STRIDE_ONE						(1UL << 20)
 
 struct yos_task {
 	int (*task_func)(void *task_data);
@@ -32,9 +60,123 @@ struct yos_task {
 	uint16_t stack_size;
 	enum yos_task_status status;
 	uint16_t block_ticks;
+	uint8_t wake_reason;
+	volatile uint32_t notify_bits;
+	uint8_t sched_lock_nesting;
+	uint8_t priority;
+	uint8_t is_suspended;
 	char name[YOS_TASK_NAME_MAX_LENGTH];
+#if (YOS_RECORD_CPU_USAGE == 1)
+	uint32_t run_ticks;
+#endif
+#if (YOS_TASK_CPU_BUDGET == 1)
+	/*
+	 * budget_ticks is 0 for a task without budget
+	 *
+	 * 予算のないタスクの場合、budget_ticksは0になります
+	 */
+	uint16_t budget_ticks;
+	uint16_t budget_period_ticks;
+	uint16_t budget_used_ticks;
+	uint32_t replenish_tick;
+	uint16_t throttle_count;
+	uint8_t is_throttled;
+#endif
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_STRIDE)
+	uint16_t tickets;
+	uint32_t stride;
+	uint32_t pass;
+#endif
+#if (YOS_SCHED_POLICY == YOS_SCHED_POLICY_EDF)
+	/*
+	 * period_ticks is 0 for a task without deadline
+	 *
+	 * デッドラインのないタスクの場合、period_ticksは0になります
+	 */
+	uint16_t period_ticks;
+	uint16_t rel_deadline_ticks;
+	uint32_t release_tick;
+	uint32_t abs_deadline;
+	uint16_t deadline_miss_count;
+	uint16_t lateness_hist[YOS_EDF_LATENESS_BUCKETS];
+#endif
 };
 
+/*
+ * Why a task blocked by yos_task_block_irq() has been woken up
+ *
+ * yos_task_block_irq()でブロックしたタスクが起こされた理由
+ */
+#define YOS_WAKE_REASON_TIMEOUT			0
+#define YOS_WAKE_REASON_SIGNALED		1
+
+/*
+ * Kernel block/wake primitive for synchronization objects
+ *
+ * yos_task_block_irq() puts the current task to wait for at most ticks
+ * (YOS_WAIT_FOREVER for no timeout). It must be called with interrupts
+ * disabled, and the task switch happens when they are enabled again.
+ * After that, yos_task_get_wake_reason() tells if the task has been woken
+ * by yos_task_wake_irq() or by timeout.
+ *
+ * yos_task_wake_irq() wakes up a waiting task, it can be called from both
+ * tasks and ISRs with interrupts disabled. Nothing happens if the task is
+ * not waiting.
+ *
+ * 同期オブジェクト用のカーネルのブロック／起床プリミティブ
+ *
+ * yos_task_block_irq()は今のタスクを最大ticksの間待たせます
+ * （タイムアウトなしはYOS_WAIT_FOREVER）。割り込み禁止の状態で呼び出す
+ * 必要があり、タスクの切り替えは割り込みを再び許可した時に行われます。
+ * その後、yos_task_get_wake_reason()でyos_task_wake_irq()に起こされたか
+ * タイムアウトしたかが分かります
+ *
+ * yos_task_wake_irq()は待っているタスクを起こします、割り込み禁止の状態で
+ * タスクからもISRからも呼び出せます。タスクが待っていない場合、何も起きません
+ */
+void yos_task_block_irq(uint16_t ticks);
+void yos_task_wake_irq(int task_id);
+int yos_task_get_wake_reason(void);
+
+/*
+ * Wake up all the tasks in a waiter bitmap(bit [task id]) and clear them,
+ * must be called with interrupts disabled
+ *
+ * 待ち手のビットマップ（ビット[タスクid]）にあるタスクをすべて起こしてクリアします
+ * 割り込み禁止の状態で呼び出す必要があります
+ */
+void yos_task_wake_waiters_irq(volatile uint32_t *waiters);
+
+/*
+ * Take(get and clear) the notification bits of the current task in bits,
+ * and mark/unmark the current task as waiting for notifications.
+ * Must be called with interrupts disabled.
+ *
+ * 今のタスクのbitsにある通知ビットを取得してクリアします、また今のタスクを
+ * 通知待ちとして登録／登録解除します
+ * 割り込み禁止の状態で呼び出す必要があります
+ */
+uint32_t yos_task_notify_take_irq(uint32_t bits);
+void yos_task_notify_set_waiting_irq(int is_waiting);
+
+/*
+ * Ticks left for a wait of timeout_ms which ends at deadline(in ticks),
+ * 0 or less if it is over.
+ *
+ * timeout_msの待ち合わせの残りtick数、終了tickはdeadline
+ * 終わっている場合は0以下になります
+ */
+static inline int32_t yos_wait_ticks_left(uint16_t timeout_ms, uint32_t deadline)
+{
+	if (timeout_ms == YOS_WAIT_FOREVER) {
+		return YOS_WAIT_FOREVER;
+	} else if (timeout_ms == 0) {
+		return 0;
+	}
+
+	return (int32_t)(deadline - yos_get_ticks());
+}
+
 
 #ifdef __cplusplus
 }
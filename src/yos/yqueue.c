@@ -0,0 +1,109 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#include <libopencm3/cm3/cortex.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "yos_core.h"
+#include "yqueue.h"
+#include "ywait.h"
+
+int yqueue_init(struct yqueue *queue, void *buf, uint16_t item_size, uint16_t capacity)
+{
+	if (queue == NULL || buf == NULL || item_size == 0 || capacity == 0) {
+		return -1;
+	}
+
+	queue->buf = (uint8_t *)buf;
+	queue->item_size = item_size;
+	queue->capacity = capacity;
+	queue->head = 0;
+	queue->count = 0;
+	queue->receive_waiters = 0;
+	queue->send_waiters = 0;
+
+	return 0;
+}
+
+int yqueue_try_send(struct yqueue *queue, const void *item)
+{
+	if (queue == NULL || item == NULL) {
+		return -1;
+	}
+
+	int ret = -1;
+	uint16_t tail;
+	uint32_t primask = cm_mask_interrupts(1);
+	if (queue->count < queue->capacity) {
+		tail = queue->head + queue->count;
+		if (tail >= queue->capacity) {
+			tail -= queue->capacity;
+		}
+		memcpy(queue->buf + (uint32_t)tail * queue->item_size, item, queue->item_size);
+		queue->count++;
+		yos_task_wake_waiters_irq(&(queue->receive_waiters));
+		ret = 0;
+	}
+	cm_mask_interrupts(primask);
+
+	return ret;
+}
+
+int yqueue_try_receive(struct yqueue *queue, void *item)
+{
+	if (queue == NULL || item == NULL) {
+		return -1;
+	}
+
+	int ret = -1;
+	uint32_t primask = cm_mask_interrupts(1);
+	if (queue->count > 0) {
+		memcpy(item, queue->buf + (uint32_t)(queue->head) * queue->item_size, queue->item_size);
+		queue->head++;
+		if (queue->head >= queue->capacity) {
+			queue->head = 0;
+		}
+		queue->count--;
+		yos_task_wake_waiters_irq(&(queue->send_waiters));
+		ret = 0;
+	}
+	cm_mask_interrupts(primask);
+
+	return ret;
+}
+
+int yqueue_send(struct yqueue *queue, const void *item, uint16_t timeout_ms)
+{
+	if (queue == NULL || item == NULL) {
+		return -1;
+	}
+
+	struct ywait_item wait_item = YWAIT_ITEM_QUEUE_SEND(queue, (void *)item);
+
+	return yos_wait_any(&wait_item, 1, timeout_ms);
+}
+
+int yqueue_receive(struct yqueue *queue, void *item, uint16_t timeout_ms)
+{
+	if (queue == NULL || item == NULL) {
+		return -1;
+	}
+
+	struct ywait_item wait_item = YWAIT_ITEM_QUEUE_RECEIVE(queue, item);
+
+	return yos_wait_any(&wait_item, 1, timeout_ms);
+}
+
+uint16_t yqueue_get_count(struct yqueue *queue)
+{
+	if (queue == NULL) {
+		return 0;
+	}
+
+	return queue->count;
+}
@@ -0,0 +1,68 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#ifndef _Y_QUEUE_H_
+#define _Y_QUEUE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Message queue of fixed size items, copied in and out
+ * The storage of capacity * item_size bytes is given by the caller.
+ *
+ * 固定サイズのアイテムのメッセージキュー、アイテムはコピーで出し入れされます
+ * capacity * item_sizeバイトの領域は呼び出し元が用意します
+ */
+struct yqueue {
+	uint8_t *buf;
+	uint16_t item_size;
+	uint16_t capacity;
+	uint16_t head;
+	volatile uint16_t count;
+	/*
+	 * Bit [task id] is set while the task is waiting to receive/send
+	 *
+	 * 受信／送信を待っているタスクのビット[タスクid]がセットされます
+	 */
+	volatile uint32_t receive_waiters;
+	volatile uint32_t send_waiters;
+};
+
+int yqueue_init(struct yqueue *queue, void *buf, uint16_t item_size, uint16_t capacity);
+
+/*
+ * Send/receive an item without waiting, can be called from ISRs.
+ * Return 0 if done, or -1(e.g. full/empty)
+ *
+ * 待たずにアイテムを送信／受信します、ISRから呼び出せます
+ * できた場合0を、その他（例：満杯／空）は-1を戻ります
+ */
+int yqueue_try_send(struct yqueue *queue, const void *item);
+int yqueue_try_receive(struct yqueue *queue, void *item);
+
+/*
+ * Block until sent/received, for at most timeout_ms
+ * (YOS_WAIT_FOREVER for no timeout).
+ * Return 0 if done, YWAIT_RET_TIMEOUT if timed out, or -1 on error
+ *
+ * 送信／受信するまで最大timeout_msの間ブロックされます
+ * （タイムアウトなしはYOS_WAIT_FOREVER）
+ * できた場合0を、タイムアウトした場合YWAIT_RET_TIMEOUTを、エラーの場合-1を戻ります
+ */
+int yqueue_send(struct yqueue *queue, const void *item, uint16_t timeout_ms);
+int yqueue_receive(struct yqueue *queue, void *item, uint16_t timeout_ms);
+
+uint16_t yqueue_get_count(struct yqueue *queue);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,188 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#include <libopencm3/cm3/cortex.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "yos_core.h"
+#include "yrwlock.h"
+#include "yatomic.h"
+#include "ybitband.h"
+
+static void _yrwlock_wake_waiters(struct yrwlock *rwlock)
+{
+	if (rwlock->waiters != 0) {
+		uint32_t primask = cm_mask_interrupts(1);
+		yos_task_wake_waiters_irq(&(rwlock->waiters));
+		cm_mask_interrupts(primask);
+	}
+}
+
+static int _yrwlock_lock(struct yrwlock *rwlock, int is_writer, uint16_t timeout_ms)
+{
+	int ret = -1;
+	int got;
+	int task_id = yos_get_current_task_id();
+	uint32_t deadline = yos_get_ticks() + _MS_TO_TICKS(timeout_ms);
+	int32_t remaining_ticks;
+	while (1) {
+		/*
+		 * Try and register as a waiter with interrupts disabled,
+		 * so a release in between cannot be missed.
+		 *
+		 * 割り込み禁止の状態で試行して待ち手として登録しますので、
+		 * その間の解放を見逃すことはありません
+		 */
+		cm_disable_interrupts();
+		if (is_writer) {
+			got = (yrwlock_try_write_lock(rwlock) == 0);
+		} else {
+			got = (yrwlock_try_read_lock(rwlock) == 0);
+		}
+
+		remaining_ticks = yos_wait_ticks_left(timeout_ms, deadline);
+		if (got || remaining_ticks <= 0) {
+			ybitband_clear(&(rwlock->waiters), (uint8_t)task_id);
+			if (is_writer) {
+				ybitband_clear(&(rwlock->writers_waiting), (uint8_t)task_id);
+			}
+			cm_enable_interrupts();
+			ret = got ? 0 : YRWLOCK_RET_TIMEOUT;
+			break;
+		}
+
+		ybitband_set(&(rwlock->waiters), (uint8_t)task_id);
+		if (is_writer) {
+			ybitband_set(&(rwlock->writers_waiting), (uint8_t)task_id);
+		}
+		yos_task_block_irq((uint16_t)remaining_ticks);
+		cm_enable_interrupts();
+	}
+
+	if (ret != 0 && is_writer) {
+		/*
+		 * Readers held back for this writer can go on now
+		 *
+		 * このライターのために止められていたリーダーは進めます
+		 */
+		_yrwlock_wake_waiters(rwlock);
+	}
+
+	return ret;
+}
+
+void yrwlock_init(struct yrwlock *rwlock, int prefer_writer)
+{
+	if (rwlock == NULL) {
+		return;
+	}
+
+	rwlock->state = 0;
+	rwlock->waiters = 0;
+	rwlock->writers_waiting = 0;
+	rwlock->prefer_writer = prefer_writer ? 1 : 0;
+}
+
+int yrwlock_try_read_lock(struct yrwlock *rwlock)
+{
+	if (rwlock == NULL) {
+		return -1;
+	}
+
+	uint32_t state;
+	do {
+		state = rwlock->state;
+		if (state & YRWLOCK_WRITER) {
+			return -1;
+		}
+		if (rwlock->prefer_writer && rwlock->writers_waiting != 0) {
+			return -1;
+		}
+	} while (!yatomic_cas32(&(rwlock->state), state, state + 1));
+
+	return 0;
+}
+
+int yrwlock_try_write_lock(struct yrwlock *rwlock)
+{
+	if (rwlock == NULL) {
+		return -1;
+	}
+
+	if (yatomic_cas32(&(rwlock->state), 0, YRWLOCK_WRITER)) {
+		return 0;
+	}
+
+	return -1;
+}
+
+int yrwlock_read_lock(struct yrwlock *rwlock, uint16_t timeout_ms)
+{
+	if (rwlock == NULL) {
+		return -1;
+	}
+
+	if (yrwlock_try_read_lock(rwlock) == 0) {
+		return 0;
+	}
+
+	return _yrwlock_lock(rwlock, 0, timeout_ms);
+}
+
+int yrwlock_write_lock(struct yrwlock *rwlock, uint16_t timeout_ms)
+{
+	if (rwlock == NULL) {
+		return -1;
+	}
+
+	if (yrwlock_try_write_lock(rwlock) == 0) {
+		return 0;
+	}
+
+	return _yrwlock_lock(rwlock, 1, timeout_ms);
+}
+
+int yrwlock_read_unlock(struct yrwlock *rwlock)
+{
+	if (rwlock == NULL) {
+		return -1;
+	}
+
+	uint32_t state;
+	do {
+		state = rwlock->state;
+		if ((state & YRWLOCK_WRITER) || state == 0) {
+			return -1;
+		}
+	} while (!yatomic_cas32(&(rwlock->state), state, state - 1));
+
+	if (state == 1) {
+		/*
+		 * The last reader, let waiting writers go
+		 *
+		 * 最後のリーダーなので、待っているライターを進めます
+		 */
+		_yrwlock_wake_waiters(rwlock);
+	}
+
+	return 0;
+}
+
+int yrwlock_write_unlock(struct yrwlock *rwlock)
+{
+	if (rwlock == NULL) {
+		return -1;
+	}
+
+	if (!yatomic_cas32(&(rwlock->state), YRWLOCK_WRITER, 0)) {
+		return -1;
+	}
+
+	_yrwlock_wake_waiters(rwlock);
+
+	return 0;
+}
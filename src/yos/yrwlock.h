@@ -0,0 +1,98 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#ifndef _Y_RWLOCK_H_
+#define _Y_RWLOCK_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Reader-writer lock
+ *
+ * Any number of readers, or one writer, can hold it at the same time.
+ * With writer preference, new readers wait while a writer is waiting,
+ * so that a writer is not starved by readers coming one after another.
+ *
+ * リーダー・ライターロック
+ *
+ * 同時に保持できるのは任意の数のリーダー、または一つのライターです。
+ * ライター優先の場合、ライターが待っている間は新しいリーダーも待ちますので、
+ * 次々に来るリーダーによってライターが飢えることはありません
+ */
+struct yrwlock {
+	/*
+	 * YRWLOCK_WRITER while held by a writer, or the number of readers
+	 *
+	 * ライターが保持している間はYRWLOCK_WRITER、その他はリーダー数
+	 */
+	volatile uint32_t state;
+	/*
+	 * Bit [task id] is set while the task is waiting,
+	 * writers_waiting for writers only
+	 *
+	 * 待っているタスクのビット[タスクid]がセットされます、
+	 * writers_waitingはライターのみ
+	 */
+	volatile uint32_t waiters;
+	volatile uint32_t writers_waiting;
+	uint8_t prefer_writer;
+};
+
+#define YRWLOCK_WRITER				0x80000000UL
+
+/*
+ * Return value of lock functions when timed out
+ *
+ * タイムアウトした時のロック関数の戻り値
+ */
+#define YRWLOCK_RET_TIMEOUT			-2
+
+void yrwlock_init(struct yrwlock *rwlock, int prefer_writer);
+
+/*
+ * Try to get the lock for reading/writing without waiting.
+ * Lock free, can be called from ISRs(unlock it in the same ISR).
+ * Return 0 if got the lock, or -1
+ *
+ * 待たずに読み込み用／書き込み用のロックを取得試行します
+ * ロックなしで、ISRから呼び出せます（同じISRでアンロックしてください）
+ * 取得できた場合0を、その他は-1を戻ります
+ */
+int yrwlock_try_read_lock(struct yrwlock *rwlock);
+int yrwlock_try_write_lock(struct yrwlock *rwlock);
+
+/*
+ * Block until got the lock for reading/writing, for at most timeout_ms
+ * (YOS_WAIT_FOREVER for no timeout).
+ * Return 0 if got the lock, YRWLOCK_RET_TIMEOUT if timed out, or -1 on error
+ *
+ * 読み込み用／書き込み用のロックを取得するまで最大timeout_msの間ブロックされます
+ * （タイムアウトなしはYOS_WAIT_FOREVER）
+ * 取得できた場合0を、タイムアウトした場合YRWLOCK_RET_TIMEOUTを、
+ * エラーの場合-1を戻ります
+ */
+int yrwlock_read_lock(struct yrwlock *rwlock, uint16_t timeout_ms);
+int yrwlock_write_lock(struct yrwlock *rwlock, uint16_t timeout_ms);
+
+/*
+ * Release the lock got for reading/writing
+ * Return 0 if released, or -1
+ *
+ * 読み込み用／書き込み用に取得したロックを解放します
+ * 解放した場合0を、その他は-1を戻ります
+ */
+int yrwlock_read_unlock(struct yrwlock *rwlock);
+int yrwlock_write_unlock(struct yrwlock *rwlock);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,89 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#include <libopencm3/cm3/cortex.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "yos_core.h"
+#include "ysem.h"
+#include "ywait.h"
+#include "yatomic.h"
+
+void ysem_init(struct ysem *sem, uint32_t initial_count, uint32_t max_count)
+{
+	if (sem == NULL) {
+		return;
+	}
+
+	sem->max_count = (max_count == 0) ? 1 : max_count;
+	sem->count = (initial_count > sem->max_count) ? sem->max_count : initial_count;
+	sem->waiters = 0;
+}
+
+int ysem_give(struct ysem *sem)
+{
+	if (sem == NULL) {
+		return -1;
+	}
+
+	uint32_t count;
+	do {
+		count = sem->count;
+		if (count >= sem->max_count) {
+			return -1;
+		}
+	} while (!yatomic_cas32(&(sem->count), count, count + 1));
+
+	if (sem->waiters != 0) {
+		uint32_t primask = cm_mask_interrupts(1);
+		yos_task_wake_waiters_irq(&(sem->waiters));
+		cm_mask_interrupts(primask);
+	}
+
+	return 0;
+}
+
+int ysem_try_take(struct ysem *sem)
+{
+	if (sem == NULL) {
+		return -1;
+	}
+
+	uint32_t count;
+	do {
+		count = sem->count;
+		if (count == 0) {
+			return -1;
+		}
+	} while (!yatomic_cas32(&(sem->count), count, count - 1));
+
+	return 0;
+}
+
+int ysem_take(struct ysem *sem, uint16_t timeout_ms)
+{
+	if (sem == NULL) {
+		return -1;
+	}
+
+	if (ysem_try_take(sem) == 0) {
+		return 0;
+	}
+
+	struct ywait_item item = YWAIT_ITEM_SEM(sem);
+
+	return yos_wait_any(&item, 1, timeout_ms);
+}
+
+uint32_t ysem_get_count(struct ysem *sem)
+{
+	if (sem == NULL) {
+		return 0;
+	}
+
+	return sem->count;
+}
@@ -0,0 +1,67 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#ifndef _Y_SEM_H_
+#define _Y_SEM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Counting semaphore
+ *
+ * カウンティングセマフォ
+ */
+struct ysem {
+	volatile uint32_t count;
+	uint32_t max_count;
+	/*
+	 * Bit [task id] is set while the task is waiting
+	 *
+	 * 待っているタスクのビット[タスクid]がセットされます
+	 */
+	volatile uint32_t waiters;
+};
+
+void ysem_init(struct ysem *sem, uint32_t initial_count, uint32_t max_count);
+
+/*
+ * Increase the count and wake up waiters, can be called from ISRs.
+ * Return 0 if given, or -1(e.g. already max_count)
+ *
+ * カウントを増やして待ち手を起こします、ISRから呼び出せます
+ * 増やした場合0を、その他（例：すでにmax_count）は-1を戻ります
+ */
+int ysem_give(struct ysem *sem);
+
+/*
+ * Decrease the count if it is not 0, can be called from ISRs.
+ * Return 0 if taken, or -1
+ *
+ * カウントが0でない場合減らします、ISRから呼び出せます
+ * 減らした場合0を、その他は-1を戻ります
+ */
+int ysem_try_take(struct ysem *sem);
+
+/*
+ * Block until taken, for at most timeout_ms(YOS_WAIT_FOREVER for no timeout).
+ * Return 0 if taken, YWAIT_RET_TIMEOUT if timed out, or -1 on error
+ *
+ * 取得するまで最大timeout_msの間ブロックされます（タイムアウトなしはYOS_WAIT_FOREVER）
+ * 取得した場合0を、タイムアウトした場合YWAIT_RET_TIMEOUTを、エラーの場合-1を戻ります
+ */
+int ysem_take(struct ysem *sem, uint16_t timeout_ms);
+
+uint32_t ysem_get_count(struct ysem *sem);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
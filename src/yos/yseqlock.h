@@ -0,0 +1,125 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#ifndef _Y_SEQLOCK_H_
+#define _Y_SEQLOCK_H_
+
+#include <stdint.h>
+#include "yatomic.h"
+#include "yos.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sequence lock
+ *
+ * For data written by a single writer and read by many readers.
+ * The writer makes the sequence odd while writing and even again when
+ * done. A reader copies the data and retries if the sequence was odd or
+ * has changed in between, so readers never block, never disable
+ * interrupts and never slow down the writer.
+ *
+ * Only one writer at a time(serialize writers by other means if needed).
+ * A reader must never preempt the writer, since it would retry forever
+ * then: not a reader in an ISR, and with priorities, not a reader task of
+ * higher priority than the writer task. YSEQLOCK_PUBLISH() keeps the
+ * scheduler locked while writing for the latter, a writer calling
+ * yseqlock_write_begin()/yseqlock_write_end() directly has to do the same
+ * (or mask interrupts, like ybus_publish()).
+ *
+ * シーケンスロック
+ *
+ * 一つのライターが書き込み、多くのリーダーが読み込むデータ用です。
+ * ライターは書き込み中にシーケンスを奇数にして、終わったら偶数に戻します。
+ * リーダーはデータをコピーして、その間にシーケンスが奇数だったか変わった場合に
+ * やり直しますので、リーダーはブロックせず、割り込みを禁止せず、
+ * ライターを遅くすることもありません
+ *
+ * 同時に書き込めるのは一つのライターのみです（必要なら他の方法で直列化してください）
+ * リーダーはライターに割り込んではいけません、永遠にやり直すことになります
+ * つまりISRのリーダー、また優先度がある場合、ライタータスクより優先度の高い
+ * リーダータスクはいけません。後者のため、YSEQLOCK_PUBLISH()は書き込み中に
+ * スケジューラーをロックします。yseqlock_write_begin()／yseqlock_write_end()を
+ * 直接呼び出すライターも同じようにする（またはybus_publish()のように
+ * 割り込みをマスクする）必要があります
+ */
+struct yseqlock {
+	volatile uint32_t sequence;
+};
+
+#define YSEQLOCK_INIT				{0}
+
+static inline void yseqlock_init(struct yseqlock *seqlock)
+{
+	seqlock->sequence = 0;
+}
+
+static inline void yseqlock_write_begin(struct yseqlock *seqlock)
+{
+	seqlock->sequence++;
+	yatomic_barrier();
+}
+
+static inline void yseqlock_write_end(struct yseqlock *seqlock)
+{
+	yatomic_barrier();
+	seqlock->sequence++;
+}
+
+static inline uint32_t yseqlock_read_begin(struct yseqlock *seqlock)
+{
+	uint32_t sequence = seqlock->sequence;
+	yatomic_barrier();
+
+	return sequence;
+}
+
+/*
+ * Return non-zero if the data read since yseqlock_read_begin() may be torn
+ *
+ * yseqlock_read_begin()から読み込んだデータが不整合の可能性がある場合、0以外を戻ります
+ */
+static inline int yseqlock_read_retry(struct yseqlock *seqlock, uint32_t sequence)
+{
+	yatomic_barrier();
+
+	return (sequence & 1) || (seqlock->sequence != sequence);
+}
+
+/*
+ * Publish src to shared, or take a consistent snapshot of shared to dst.
+ * Any assignable type(e.g. a struct) can be used.
+ * YSEQLOCK_PUBLISH() is for tasks, as it locks the scheduler.
+ *
+ * srcをsharedに公開します、またはsharedの整合したスナップショットをdstに取ります
+ * 代入できる型（例えば構造体）なら何でも使えます
+ * YSEQLOCK_PUBLISH()はスケジューラーをロックしますので、タスク用です
+ */
+#define YSEQLOCK_PUBLISH(seqlock, shared, src)							\
+	do {																\
+		yos_sched_lock();												\
+		yseqlock_write_begin(seqlock);									\
+		(shared) = (src);												\
+		yseqlock_write_end(seqlock);									\
+		yos_sched_unlock();												\
+	} while (0)
+
+#define YSEQLOCK_SNAPSHOT(seqlock, dst, shared)							\
+	do {																\
+		uint32_t _yseqlock_seq;											\
+		do {															\
+			_yseqlock_seq = yseqlock_read_begin(seqlock);				\
+			(dst) = (shared);											\
+		} while (yseqlock_read_retry((seqlock), _yseqlock_seq));		\
+	} while (0)
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "ytimer.h"
+#include "ybitband.h"
 
 #define DEFAULT_USER_TIMER				TIM4
 #define DEFAULT_USER_TIMER_RCC			RCC_TIM4
@@ -20,41 +21,224 @@
 #define DEFAULT_USER_TIMER_RST			RST_TIM4
 #define DEFAULT_USER_TIMER_IRS			tim4_isr
 
+/*
+ * Hierarchical timing wheel
+ *
+ * Level 0 has one slot per ms, and every upper level has one slot per
+ * a whole round of the level below it. A timer is put into the slot
+ * of the lowest level that can cover its remaining time, and is moved
+ * down(cascaded) when the lower level wraps around. So inserting and
+ * removing a timer are O(1), and the work done per tick does not depend
+ * on the number of timers.
+ *
+ * 階層タイミングホイール
+ *
+ * レベル0のスロットは1msごと、上のレベルのスロットは下のレベル一周分ごとになります。
+ * タイマーは残り時間をカバーできる一番下のレベルのスロットに入れられて、
+ * 下のレベルが一周したら下のレベルに移されます（カスケード）。
+ * そのため、タイマーの追加と削除はO(1)で、tickごとの処理量はタイマーの数と関係ありません。
+ */
+#define _UT_WHEEL_BITS					6
+#define _UT_WHEEL_SIZE					(1 << _UT_WHEEL_BITS)
+#define _UT_WHEEL_MASK					(_UT_WHEEL_SIZE - 1)
+#define _UT_WHEEL_LEVELS				4
+#define _UT_WHEEL_MAX_DELTA				((1UL << (_UT_WHEEL_BITS * _UT_WHEEL_LEVELS)) - 1)
+
+#define _UT_NIL							0xFFFF
+#define _UT_LEVEL_EXPIRING				0xFF
+
+#if (USER_TIMER_MAX_COUNT >= _UT_NIL)
+#error "USER_TIMER_MAX_COUNT is too large!"
+#endif
+
 static struct user_timer {
 	void (*on_timeout)(void *para);
 	void *para;
-	uint32_t remaining_ms;
+	/*
+	 * Expiring ms tick, or the remaining ms while paused
+	 *
+	 * 満了するmsのtick、一時停止中の場合は残りms
+	 */
+	uint32_t expires;
 	uint32_t init_ms;
+	uint16_t next;
+	uint16_t prev;
+	uint8_t level;
+	uint8_t slot;
 	uint8_t auto_restart;
 	uint8_t is_paused;
 	uint8_t is_used;
 } _user_timer_list[USER_TIMER_MAX_COUNT];
 
+static uint16_t _ut_wheel[_UT_WHEEL_LEVELS][_UT_WHEEL_SIZE];
+static uint16_t _ut_free_list;
+
+/*
+ * Timers expiring in the tick being processed
+ *
+ * 処理中のtickで満了するタイマー
+ */
+static uint16_t _ut_expiring;
+
+/*
+ * The ms tick to be processed next
+ *
+ * 次に処理するmsのtick
+ */
+static volatile uint32_t _ut_wheel_now;
+
+/*
+ * Bit [timer id] is set while the timer is in the wheel(i.e. running).
+ * Updated by bit-band stores, so it can be read without disabling the
+ * timer interrupt.
+ *
+ * ホイールにある（つまり動いている）タイマーのビット[タイマーid]がセットされます
+ * ビットバンドのストアで更新されますので、タイマー割り込みを禁止せずに読み込めます
+ */
+static volatile uint32_t _ut_armed_map[YBITMAP_WORDS(USER_TIMER_MAX_COUNT)];
+
+/*
+ * Set while a benchmark owns the wheel(see user_timer_bench_start()).
+ * The other calls changing the wheel fail then, and leave the timer
+ * interrupt disabled.
+ *
+ * ベンチマークがホイールを所有している間セットされます（user_timer_bench_start()を参照）
+ * その間ホイールを変更する他の呼び出しは失敗し、タイマー割り込みは禁止のままにします
+ */
+static volatile uint8_t _ut_bench_active = 0;
+
+static uint16_t *_ut_list_head(uint8_t level, uint8_t slot)
+{
+	if (level == _UT_LEVEL_EXPIRING) {
+		return &_ut_expiring;
+	}
+
+	return &(_ut_wheel[level][slot]);
+}
+
+static void _ut_wheel_insert(uint16_t id)
+{
+	struct user_timer *ut = _user_timer_list + id;
+	uint32_t delta = ut->expires - _ut_wheel_now;
+	uint32_t pos;
+	uint8_t level;
+
+	if (delta > _UT_WHEEL_MAX_DELTA) {
+		/*
+		 * Too far away, park it at the top level and it will be
+		 * put back again when cascaded.
+		 *
+		 * 遠すぎるので一番上のレベルに置いて、カスケード時に再配置します
+		 */
+		delta = _UT_WHEEL_MAX_DELTA;
+	}
+	pos = _ut_wheel_now + delta;
+
+	level = 0;
+	while (level < _UT_WHEEL_LEVELS - 1
+		&& delta >= (1UL << (_UT_WHEEL_BITS * (level + 1)))) {
+		level++;
+	}
+
+	ut->level = level;
+	ut->slot = (pos >> (_UT_WHEEL_BITS * level)) & _UT_WHEEL_MASK;
+	ut->prev = _UT_NIL;
+	ut->next = _ut_wheel[level][ut->slot];
+	if (ut->next != _UT_NIL) {
+		_user_timer_list[ut->next].prev = id;
+	}
+	_ut_wheel[level][ut->slot] = id;
+	ybitmap_set(_ut_armed_map, id);
+}
+
+static void _ut_wheel_remove(uint16_t id)
+{
+	struct user_timer *ut = _user_timer_list + id;
+
+	if (ut->prev != _UT_NIL) {
+		_user_timer_list[ut->prev].next = ut->next;
+	} else {
+		*_ut_list_head(ut->level, ut->slot) = ut->next;
+	}
+	if (ut->next != _UT_NIL) {
+		_user_timer_list[ut->next].prev = ut->prev;
+	}
+	ut->next = ut->prev = _UT_NIL;
+	ybitmap_clear(_ut_armed_map, id);
+}
+
+static void _ut_wheel_cascade(uint8_t level, uint8_t slot)
+{
+	uint16_t id = _ut_wheel[level][slot];
+	uint16_t next;
+
+	_ut_wheel[level][slot] = _UT_NIL;
+	while (id != _UT_NIL) {
+		next = _user_timer_list[id].next;
+		_ut_wheel_insert(id);
+		id = next;
+	}
+}
+
 static void _user_timer_list_check_in_irq(void)
 {
-	int i = 0;
+	uint32_t now = _ut_wheel_now;
+	uint8_t slot = now & _UT_WHEEL_MASK;
+	uint8_t level = 1;
+	uint16_t id;
 	struct user_timer *ut;
-	while (i < USER_TIMER_MAX_COUNT) {
-		ut = _user_timer_list + i;
-		if (ut->is_used) {
-			if (!(ut->is_paused)) {
-				if (ut->remaining_ms == 0) {
-					if (ut->on_timeout != NULL) {
-						ut->on_timeout(ut->para);
-					}
-
-					if (ut->auto_restart) {
-						ut->remaining_ms = ut->init_ms;
-					} else {
-						ut->is_used = 0;
-					}
-				} else {
-					ut->remaining_ms--;
-				}
-			}
+
+	/*
+	 * Cascade upper levels which come to a new round
+	 *
+	 * 新しい一周になった上のレベルをカスケードします
+	 */
+	while (level < _UT_WHEEL_LEVELS
+		&& ((now >> (_UT_WHEEL_BITS * (level - 1))) & _UT_WHEEL_MASK) == 0) {
+		_ut_wheel_cascade(level, (now >> (_UT_WHEEL_BITS * level)) & _UT_WHEEL_MASK);
+		level++;
+	}
+
+	_ut_wheel_now = now + 1;
+
+	/*
+	 * Move the expiring timers to a separate list first, so that timers
+	 * created or restarted by the callbacks will not be mixed in.
+	 *
+	 * 満了するタイマーを先に別のリストに移します、コールバックで作成また
+	 * 再開されたタイマーと混ざらないようにするためです
+	 */
+	_ut_expiring = _ut_wheel[0][slot];
+	_ut_wheel[0][slot] = _UT_NIL;
+	id = _ut_expiring;
+	while (id != _UT_NIL) {
+		_user_timer_list[id].level = _UT_LEVEL_EXPIRING;
+		id = _user_timer_list[id].next;
+	}
+
+	/*
+	 * Timers are unlinked one by one before the callback is called,
+	 * so the callback is free to create, reset or destroy timers.
+	 *
+	 * コールバックを呼び出す前にタイマーを一つずつ外しますので、
+	 * コールバックの中でタイマーを作成、リセット、削除しても大丈夫です
+	 */
+	while ((id = _ut_expiring) != _UT_NIL) {
+		ut = _user_timer_list + id;
+		_ut_wheel_remove(id);
+
+		if (ut->auto_restart) {
+			ut->expires = _ut_wheel_now + ut->init_ms;
+			_ut_wheel_insert(id);
+		} else {
+			ut->is_used = 0;
+			ut->next = _ut_free_list;
+			_ut_free_list = id;
 		}
 
-		i++;
+		if (ut->on_timeout != NULL) {
+			ut->on_timeout(ut->para);
+		}
 	}
 }
 
@@ -69,7 +253,19 @@ static void _user_timer_interrupt_enable(int enable)
 
 static void _user_timer_list_init(void)
 {
+	int i;
+
 	memset(&_user_timer_list, 0x00, sizeof(_user_timer_list));
+	memset(&_ut_wheel, 0xFF, sizeof(_ut_wheel));
+	memset((void *)_ut_armed_map, 0x00, sizeof(_ut_armed_map));
+
+	for (i = 0; i < USER_TIMER_MAX_COUNT; i++) {
+		_user_timer_list[i].next = (i + 1 < USER_TIMER_MAX_COUNT) ? i + 1 : _UT_NIL;
+		_user_timer_list[i].prev = _UT_NIL;
+	}
+	_ut_free_list = 0;
+	_ut_expiring = _UT_NIL;
+	_ut_wheel_now = 0;
 }
 
 int user_timer_init(void)
@@ -118,31 +314,46 @@ void DEFAULT_USER_TIMER_IRS(void)
 	}
 }
 
-int user_timer_create(uint32_t timeout_ms, int auto_restart,
+/*
+ * Take a timer from the free list and put it into the wheel,
+ * called with the timer interrupt disabled
+ *
+ * フリーリストからタイマーを取ってホイールに入れます
+ * タイマー割り込みを禁止した状態で呼び出されます
+ */
+static int _user_timer_create_irq(uint32_t timeout_ms, int auto_restart,
 	void (*on_timeout)(void *para), void *timeout_para)
 {
 	int timer_id = -1;
-	int i = 0;
 
 	struct user_timer *ut;
-	_user_timer_interrupt_enable(0);
-	while (i < USER_TIMER_MAX_COUNT) {
-		ut = _user_timer_list + i;
-		if (!(ut->is_used)) {
-			ut->on_timeout = on_timeout;
-			ut->para = timeout_para;
-			ut->remaining_ms = timeout_ms;
-			ut->init_ms = timeout_ms;
-			ut->auto_restart = auto_restart;
-			ut->is_paused = 0;
-			ut->is_used = 1;
-
-			timer_id = i;
-			break;
-		}
+	if (_ut_free_list != _UT_NIL) {
+		timer_id = _ut_free_list;
+		ut = _user_timer_list + timer_id;
+		_ut_free_list = ut->next;
+
+		ut->on_timeout = on_timeout;
+		ut->para = timeout_para;
+		ut->expires = _ut_wheel_now + timeout_ms;
+		ut->init_ms = timeout_ms;
+		ut->auto_restart = auto_restart;
+		ut->is_paused = 0;
+		ut->is_used = 1;
+		_ut_wheel_insert(timer_id);
+	}
 
-		i++;
+	return timer_id;
+}
+
+int user_timer_create(uint32_t timeout_ms, int auto_restart,
+	void (*on_timeout)(void *para), void *timeout_para)
+{
+	_user_timer_interrupt_enable(0);
+	if (_ut_bench_active) {
+		return -1;
 	}
+
+	int timer_id = _user_timer_create_irq(timeout_ms, auto_restart, on_timeout, timeout_para);
 	_user_timer_interrupt_enable(1);
 
 	return timer_id;
@@ -150,14 +361,25 @@ int user_timer_create(uint32_t timeout_ms, int auto_restart,
 
 static int _user_timer_pause_set(int timer_id, uint8_t pause)
 {
-	if (timer_id < 0 || timer_id > USER_TIMER_MAX_COUNT) {
+	if (timer_id < 0 || timer_id >= USER_TIMER_MAX_COUNT) {
 		return -1;
 	}
 
 	struct user_timer *ut;
 	_user_timer_interrupt_enable(0);
+	if (_ut_bench_active) {
+		return -1;
+	}
+
 	ut = _user_timer_list + timer_id;
-	if (ut->is_used) {
+	if (ut->is_used && ut->is_paused != pause) {
+		if (pause) {
+			ut->expires = ut->expires - _ut_wheel_now;
+			_ut_wheel_remove(timer_id);
+		} else {
+			ut->expires = _ut_wheel_now + ut->expires;
+			_ut_wheel_insert(timer_id);
+		}
 		ut->is_paused = pause;
 	}
 	_user_timer_interrupt_enable(1);
@@ -177,16 +399,26 @@ int user_timer_restore(int timer_id)
 
 int user_timer_reset(int timer_id, uint32_t timeout_ms)
 {
-	if (timer_id < 0 || timer_id > USER_TIMER_MAX_COUNT) {
+	if (timer_id < 0 || timer_id >= USER_TIMER_MAX_COUNT) {
 		return -1;
 	}
 
 	struct user_timer *ut;
 	_user_timer_interrupt_enable(0);
+	if (_ut_bench_active) {
+		return -1;
+	}
+
 	ut = _user_timer_list + timer_id;
 	if (ut->is_used) {
-		ut->remaining_ms = timeout_ms;
 		ut->init_ms = timeout_ms;
+		if (ut->is_paused) {
+			ut->expires = timeout_ms;
+		} else {
+			_ut_wheel_remove(timer_id);
+			ut->expires = _ut_wheel_now + timeout_ms;
+			_ut_wheel_insert(timer_id);
+		}
 	}
 	_user_timer_interrupt_enable(1);
 
@@ -195,40 +427,124 @@ int user_timer_reset(int timer_id, uint32_t timeout_ms)
 
 uint32_t user_timer_get_remaining_ms(int timer_id)
 {
-	if (timer_id < 0 || timer_id > USER_TIMER_MAX_COUNT) {
+	if (timer_id < 0 || timer_id >= USER_TIMER_MAX_COUNT) {
 		return 0;
 	}
 
 	uint32_t remaining = 0;
 	struct user_timer *ut;
 	_user_timer_interrupt_enable(0);
+	if (_ut_bench_active) {
+		return 0;
+	}
+
 	ut = _user_timer_list + timer_id;
 	if (ut->is_used) {
-		remaining = ut->remaining_ms;
+		if (ut->is_paused) {
+			remaining = ut->expires;
+		} else {
+			remaining = ut->expires - _ut_wheel_now;
+		}
 	}
 	_user_timer_interrupt_enable(1);
 
 	return remaining;
 }
 
+int user_timer_is_armed(int timer_id)
+{
+	if (timer_id < 0 || timer_id >= USER_TIMER_MAX_COUNT) {
+		return 0;
+	}
+
+	return ybitmap_get(_ut_armed_map, timer_id);
+}
+
 int user_timer_destroy(int timer_id)
 {
-	if (timer_id < 0 || timer_id > USER_TIMER_MAX_COUNT) {
+	if (timer_id < 0 || timer_id >= USER_TIMER_MAX_COUNT) {
 		return -1;
 	}
 
 	struct user_timer *ut;
 	_user_timer_interrupt_enable(0);
+	if (_ut_bench_active) {
+		return -1;
+	}
+
 	ut = _user_timer_list + timer_id;
 	if (ut->is_used) {
-		//ut->on_timeout = NULL;
-		//ut->para = NULL;
-		//ut->remaining_ms = 0;
-		//ut->auto_restart = 0;
-		//ut->is_paused = 0;
+		if (!(ut->is_paused)) {
+			_ut_wheel_remove(timer_id);
+		}
 		ut->is_used = 0;
+		ut->next = _ut_free_list;
+		_ut_free_list = timer_id;
 	}
 	_user_timer_interrupt_enable(1);
 
 	return 0;
 }
+
+int user_timer_bench_start(int timer_count)
+{
+	if (timer_count < 0 || timer_count > USER_TIMER_MAX_COUNT) {
+		return -1;
+	}
+
+	int i;
+	_user_timer_interrupt_enable(0);
+	if (_ut_bench_active) {
+		return -1;
+	}
+
+	for (i = 0; i < USER_TIMER_MAX_COUNT; i++) {
+		if (_user_timer_list[i].is_used) {
+			_user_timer_interrupt_enable(1);
+			return -1;
+		}
+	}
+	_ut_bench_active = 1;
+
+	/*
+	 * Periods are spread over 1 to 4000 ms, so that the timers are in
+	 * level 0 and 1, and some of them expire and cascade while ticking.
+	 *
+	 * 周期は1～4000msに分散させ、タイマーがレベル0と1にあり、
+	 * tickの間に一部が満了やカスケードするようにします
+	 */
+	for (i = 0; i < timer_count; i++) {
+		_user_timer_create_irq(1 + ((uint32_t)i * 97) % 4000, 1, NULL, NULL);
+	}
+
+	return 0;
+}
+
+void user_timer_bench_tick(void)
+{
+	_user_timer_list_check_in_irq();
+}
+
+void user_timer_bench_stop(void)
+{
+	if (!_ut_bench_active) {
+		return;
+	}
+
+	/*
+	 * Nobody else could create timers meanwhile, so all of them are ours
+	 *
+	 * その間に他はタイマーを作成できないので、すべて自分のものです
+	 */
+	int i;
+	for (i = 0; i < USER_TIMER_MAX_COUNT; i++) {
+		if (_user_timer_list[i].is_used) {
+			_ut_wheel_remove(i);
+			_user_timer_list[i].is_used = 0;
+			_user_timer_list[i].next = _ut_free_list;
+			_ut_free_list = i;
+		}
+	}
+	_ut_bench_active = 0;
+	_user_timer_interrupt_enable(1);
+}
@@ -14,7 +14,15 @@
 extern "C" {
 #endif
 
-#define USER_TIMER_MAX_COUNT			8
+/*
+ * Timers are kept in a hierarchical timing wheel, so create/pause/reset/destroy
+ * and the work per ms tick do not depend on this count. Each timer takes
+ * 28 bytes of RAM.
+ *
+ * タイマーは階層タイミングホイールで管理されますので、作成、一時停止、リセット、
+ * 削除およびmsごとの処理はこの数と関係ありません。タイマー一つはRAMを28バイト使います。
+ */
+#define USER_TIMER_MAX_COUNT			128
 
 int user_timer_init(void);
 int user_timer_deinit(void);
@@ -26,8 +34,39 @@ int user_timer_pause(int timer_id);
 int user_timer_restore(int timer_id);
 int user_timer_reset(int timer_id, uint32_t timeout_ms);
 uint32_t user_timer_get_remaining_ms(int timer_id);
+
+/*
+ * Return 1 if the timer is running(created and not paused), or 0.
+ * Lock free, can be called from ISRs.
+ *
+ * タイマーが動いている（作成済みで一時停止していない）場合1を、その他は0を戻ります
+ * ロックなしで、ISRから呼び出せます
+ */
+int user_timer_is_armed(int timer_id);
 int user_timer_destroy(int timer_id);
 
+/*
+ * For benchmarks only(see ybench.c)
+ * user_timer_bench_start() arms timer_count auto restart timers and keeps
+ * the timer interrupt disabled until user_timer_bench_stop(), which
+ * destroys all the timers. user_timer_bench_tick() processes one ms tick
+ * of the wheel.
+ * Return -1 if some timers are already in use, as ticking the wheel
+ * would make them expire early. Until user_timer_bench_stop(), the other
+ * calls changing timers fail(user_timer_create() etc. return -1).
+ *
+ * ベンチマーク専用（ybench.cを参照）
+ * user_timer_bench_start()はtimer_count個の自動再開タイマーを動かして、
+ * すべてのタイマーを削除するuser_timer_bench_stop()までタイマー割り込みを
+ * 禁止したままにします。user_timer_bench_tick()はホイールの1ms tickを処理します
+ * ホイールを進めると早く満了してしまうので、既に使われているタイマーがある場合
+ * -1を戻ります。user_timer_bench_stop()までタイマーを変更する他の呼び出しは
+ * 失敗します（user_timer_create()などは-1を戻ります）
+ */
+int user_timer_bench_start(int timer_count);
+void user_timer_bench_tick(void);
+void user_timer_bench_stop(void);
+
 
 #ifdef __cplusplus
 }
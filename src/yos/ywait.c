@@ -0,0 +1,140 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#include <libopencm3/cm3/cortex.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "yos_core.h"
+#include "ywait.h"
+#include "ysem.h"
+#include "yqueue.h"
+#include "yevent.h"
+#include "yatomic.h"
+#include "ybitband.h"
+
+/*
+ * Waiter bitmap of the object of the item, NULL for notifications
+ *
+ * アイテムのオブジェクトの待ち手ビットマップ、通知の場合はNULL
+ */
+static volatile uint32_t *_ywait_waiters(struct ywait_item *item)
+{
+	switch (item->type) {
+	case YWAIT_SEM:
+		return &(((struct ysem *)(item->object))->waiters);
+	case YWAIT_QUEUE_RECEIVE:
+		return &(((struct yqueue *)(item->object))->receive_waiters);
+	case YWAIT_QUEUE_SEND:
+		return &(((struct yqueue *)(item->object))->send_waiters);
+	case YWAIT_EVENT_FLAGS:
+		return &(((struct yevent_flags *)(item->object))->waiters);
+	default:
+		return NULL;
+	}
+}
+
+/*
+ * Try the item once, return non-zero if it is satisfied(and done)
+ * Called with interrupts disabled.
+ *
+ * アイテムを一回試行します、満たされた（そして実行した）場合0以外を戻ります
+ * 割り込み禁止の状態で呼び出されます
+ */
+static int _ywait_try_irq(struct ywait_item *item)
+{
+	struct yevent_flags *ev;
+	switch (item->type) {
+	case YWAIT_SEM:
+		return (ysem_try_take((struct ysem *)(item->object)) == 0);
+	case YWAIT_QUEUE_RECEIVE:
+		return (yqueue_try_receive((struct yqueue *)(item->object), item->buf) == 0);
+	case YWAIT_QUEUE_SEND:
+		return (yqueue_try_send((struct yqueue *)(item->object), item->buf) == 0);
+	case YWAIT_EVENT_FLAGS:
+		ev = (struct yevent_flags *)(item->object);
+		item->result = ev->flags & item->bits;
+		if (item->result != 0) {
+			yatomic_clear_bits32(&(ev->flags), item->result);
+		}
+		return (item->result != 0);
+	case YWAIT_NOTIFY:
+		item->result = yos_task_notify_take_irq(item->bits);
+		return (item->result != 0);
+	default:
+		return 0;
+	}
+}
+
+static void _ywait_register_irq(struct ywait_item *items, int item_count, int task_id, int is_waiting)
+{
+	volatile uint32_t *waiters;
+	int i = 0;
+	while (i < item_count) {
+		waiters = _ywait_waiters(items + i);
+		if (waiters != NULL) {
+			ybitband_write(waiters, (uint8_t)task_id, is_waiting);
+		} else {
+			yos_task_notify_set_waiting_irq(is_waiting);
+		}
+
+		i++;
+	}
+}
+
+int yos_wait_any(struct ywait_item *items, int item_count, uint16_t timeout_ms)
+{
+	if (items == NULL || item_count <= 0) {
+		return -1;
+	}
+
+	int i = 0;
+	while (i < item_count) {
+		if (items[i].type != YWAIT_NOTIFY && items[i].object == NULL) {
+			return -1;
+		}
+		items[i].result = 0;
+
+		i++;
+	}
+
+	int ret = YWAIT_RET_TIMEOUT;
+	int task_id = yos_get_current_task_id();
+	uint32_t deadline = yos_get_ticks() + _MS_TO_TICKS(timeout_ms);
+	int32_t remaining_ticks;
+	while (1) {
+		/*
+		 * Items are tried, and the task is registered to all of them,
+		 * with interrupts disabled, so no signal in between can be missed.
+		 *
+		 * アイテムの試行とすべてへのタスクの登録は割り込み禁止の状態で行いますので、
+		 * その間の通知を見逃すことはありません
+		 */
+		cm_disable_interrupts();
+		i = 0;
+		while (i < item_count) {
+			if (_ywait_try_irq(items + i)) {
+				ret = i;
+				break;
+			}
+
+			i++;
+		}
+
+		remaining_ticks = yos_wait_ticks_left(timeout_ms, deadline);
+		if (ret >= 0 || remaining_ticks <= 0) {
+			_ywait_register_irq(items, item_count, task_id, 0);
+			cm_enable_interrupts();
+			break;
+		}
+
+		_ywait_register_irq(items, item_count, task_id, 1);
+		yos_task_block_irq((uint16_t)remaining_ticks);
+		cm_enable_interrupts();
+	}
+
+	return ret;
+}
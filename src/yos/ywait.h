@@ -0,0 +1,93 @@
+/*
+ * YOS
+ *
+ * Copyright(C) 2025 Ashibananon(Yuan).
+ *
+ */
+
+#ifndef _Y_WAIT_H_
+#define _Y_WAIT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * What to wait for
+ *
+ * YWAIT_SEM:				Take the semaphore(object: struct ysem)
+ * YWAIT_QUEUE_RECEIVE:		Receive an item into buf(object: struct yqueue)
+ * YWAIT_QUEUE_SEND:		Send the item in buf(object: struct yqueue)
+ * YWAIT_EVENT_FLAGS:		Any of bits set, they are cleared and put into
+ *							result(object: struct yevent_flags)
+ * YWAIT_NOTIFY:			Any of notification bits of the current task,
+ *							they are cleared and put into result(object: NULL)
+ *
+ * 待つもの
+ *
+ * YWAIT_SEM:				セマフォを取得します（object: struct ysem）
+ * YWAIT_QUEUE_RECEIVE:		アイテムをbufに受信します（object: struct yqueue）
+ * YWAIT_QUEUE_SEND:		bufにあるアイテムを送信します（object: struct yqueue）
+ * YWAIT_EVENT_FLAGS:		bitsのいずれかがセットされる、それらはクリアされて
+ *							resultに入れられます（object: struct yevent_flags）
+ * YWAIT_NOTIFY:			今のタスクの通知ビットのいずれか、それらはクリアされて
+ *							resultに入れられます（object: NULL）
+ */
+enum ywait_type {
+	YWAIT_SEM = 0,
+	YWAIT_QUEUE_RECEIVE,
+	YWAIT_QUEUE_SEND,
+	YWAIT_EVENT_FLAGS,
+	YWAIT_NOTIFY
+};
+
+struct ywait_item {
+	enum ywait_type type;
+	void *object;
+	void *buf;
+	uint32_t bits;
+	uint32_t result;
+};
+
+#define YWAIT_ITEM_SEM(sem)							{.type = YWAIT_SEM, .object = (sem)}
+#define YWAIT_ITEM_QUEUE_RECEIVE(queue, item_buf)	{.type = YWAIT_QUEUE_RECEIVE, .object = (queue), .buf = (item_buf)}
+#define YWAIT_ITEM_QUEUE_SEND(queue, item_buf)		{.type = YWAIT_QUEUE_SEND, .object = (queue), .buf = (item_buf)}
+#define YWAIT_ITEM_EVENT_FLAGS(ev, wait_bits)		{.type = YWAIT_EVENT_FLAGS, .object = (ev), .bits = (wait_bits)}
+#define YWAIT_ITEM_NOTIFY(wait_bits)				{.type = YWAIT_NOTIFY, .object = NULL, .bits = (wait_bits)}
+
+/*
+ * Return value of wait functions when timed out
+ *
+ * タイムアウトした時の待ち合わせ関数の戻り値
+ */
+#define YWAIT_RET_TIMEOUT				-2
+
+/*
+ * Wait until any of the items is satisfied, for at most timeout_ms
+ * (0 for not waiting, YOS_WAIT_FOREVER for no timeout).
+ *
+ * The task is registered as a waiter of every object and sleeps, and it
+ * is woken up by whichever signals first, so no CPU time is spent while
+ * waiting. Only the first satisfied item(in the array order) is done.
+ *
+ * Return the index of the satisfied item, YWAIT_RET_TIMEOUT if timed out,
+ * or -1 on error. Do not call this from ISRs.
+ *
+ * itemsのいずれかが満たされるまで最大timeout_msの間待ちます
+ * （0は待たない、YOS_WAIT_FOREVERはタイムアウトなし）
+ *
+ * タスクはすべてのオブジェクトの待ち手として登録されて寝ます、先に通知したものに
+ * 起こされますので、待っている間CPU時間は使いません。最初に満たされた
+ * アイテム（配列の順番）のみ実行されます
+ *
+ * 満たされたアイテムのインデックスを、タイムアウトした場合YWAIT_RET_TIMEOUTを、
+ * エラーの場合-1を戻ります。ISRから呼び出さないでください
+ */
+int yos_wait_any(struct ywait_item *items, int item_count, uint16_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
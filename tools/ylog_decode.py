@@ -0,0 +1,283 @@
+#!/usr/bin/env python3
+#
+# YOS
+#
+# Copyright(C) 2025 Ashibananon(Yuan).
+#
+# Decode the binary records shipped by ylog_task()(see src/yos/ylog.h)
+# with the format strings taken from the ELF file of the firmware.
+#
+# ylog_task()が送ったバイナリレコード（src/yos/ylog.hを参照）を
+# ファームウェアのELFファイルから取ったフォーマット文字列でデコードします
+#
+# Usage（使い方）:
+#   ylog_decode.py .pio/build/genericSTM32F103C8/firmware.elf capture.bin
+#   ylog_decode.py firmware.elf --port /dev/ttyUSB1 --baud 921600  (needs pyserial)
+#
+
+import argparse
+import re
+import struct
+import sys
+
+YLOG_SECTION = "ylog_fmt"
+YLOG_SYNC_BYTE = 0xA5
+YLOG_HEADER_VALID = 1 << 31
+YLOG_HEADER_ARGC_SHIFT = 27
+YLOG_HEADER_ARGC_MASK = 0x0F
+YLOG_HEADER_TICKS_SHIFT = 16
+YLOG_HEADER_TICKS_MASK = 0x07FF
+YLOG_HEADER_ID_MASK = 0xFFFF
+YLOG_ID_DROPPED = 0xFFFF
+YLOG_MAX_ARG_COUNT = 8
+
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+
+class Elf:
+    """Minimal 32 bit little endian ELF reader, sections only"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError("%s is not a 32 bit little endian ELF file" % path)
+
+        (e_shoff,) = struct.unpack_from("<I", self.data, 0x20)
+        e_shentsize, e_shnum, e_shstrndx = struct.unpack_from("<HHH", self.data, 0x2E)
+        headers = [struct.unpack_from("<IIIIIIIIII", self.data, e_shoff + i * e_shentsize)
+                   for i in range(e_shnum)]
+        strtab = headers[e_shstrndx]
+
+        self.sections = {}
+        self.alloc_sections = []
+        for h in headers:
+            name_off, sh_type, flags, addr, offset, size = h[:6]
+            name = self._cstr(strtab[4] + name_off)
+            self.sections[name] = (addr, offset, size, sh_type)
+            if sh_type != SHT_NOBITS and (flags & SHF_ALLOC) and size > 0:
+                self.alloc_sections.append((addr, offset, size))
+
+    def _cstr(self, offset):
+        end = self.data.index(b"\0", offset)
+        return self.data[offset:end].decode("utf-8", "replace")
+
+    def section_string(self, name, index):
+        addr, offset, size, _ = self.sections[name]
+        if index >= size:
+            return None
+        return self._cstr(offset + index)
+
+    def string_at(self, addr):
+        for sec_addr, offset, size in self.alloc_sections:
+            if sec_addr <= addr < sec_addr + size:
+                return self._cstr(offset + addr - sec_addr)
+        return None
+
+
+# Same conversions as lib/yfmt/yfmt.c
+# lib/yfmt/yfmt.cと同じ変換
+_SPEC = re.compile(r"%([-0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|l|z)?([diuxXcsq%])")
+
+
+def _to_signed(value, length):
+    bits = {"hh": 8, "h": 16}.get(length, 32)
+    value &= (1 << bits) - 1
+    if value & (1 << (bits - 1)):
+        value -= 1 << bits
+    return value
+
+
+def format_record(fmt, args, elf):
+    args = list(args)
+
+    def next_arg():
+        return args.pop(0) if args else 0
+
+    def repl(m):
+        flags, width, precision, length, conv = m.groups()
+        if conv == "%":
+            return "%"
+        if width == "*":
+            width = _to_signed(next_arg(), None)
+            if width < 0:
+                flags += "-"
+                width = -width
+        width = int(width) if width else 0
+        if precision == "*":
+            precision = _to_signed(next_arg(), None)
+        elif precision is not None:
+            precision = int(precision) if precision else 0
+        value = next_arg()
+
+        sign = ""
+        if conv in "diq":
+            value = _to_signed(value, length)
+            if value < 0:
+                sign = "-"
+                value = -value
+            if conv == "q":
+                prec = 1 if precision is None or precision < 0 else min(precision, 9)
+                digits = str(value).rjust(prec + 1, "0")
+                body = digits[:-prec] + "." + digits[-prec:] if prec > 0 else digits
+            else:
+                body = str(value).rjust(precision or 1, "0")
+        elif conv in "uxX":
+            if length == "hh":
+                value &= 0xFF
+            elif length == "h":
+                value &= 0xFFFF
+            body = {"u": "%d", "x": "%x", "X": "%X"}[conv] % value
+            body = body.rjust(precision or 1, "0")
+        elif conv == "c":
+            body = chr(value & 0xFF)
+        else:
+            s = elf.string_at(value)
+            body = s if s is not None else "<0x%08X>" % value
+            if precision is not None and precision >= 0:
+                body = body[:precision]
+
+        pad = width - len(sign) - len(body)
+        if pad <= 0:
+            return sign + body
+        if "-" in flags:
+            return sign + body + " " * pad
+        if "0" in flags and conv not in "cs":
+            return sign + "0" * pad + body
+        return " " * pad + sign + body
+
+    return _SPEC.sub(repl, fmt)
+
+
+def _read_u32_leb128(data, pos):
+    value = 0
+    shift = 0
+    while pos < len(data) and shift < 35:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if b & 0x80 == 0:
+            return value & 0xFFFFFFFF, pos
+        shift += 7
+    return None, pos
+
+
+class Decoder:
+    def __init__(self, elf, hz):
+        self.elf = elf
+        self.hz = hz
+        self.buf = bytearray()
+        self.ticks = None
+        self.bytes_in = 0
+        self.text_bytes = 0
+
+    def _timestamp(self, low_ticks):
+        # Ticks in the header are only 11 bits, unwrap them assuming in order
+        # ヘッダーのtickは11ビットのみですので、順番通りと仮定して巻き戻しを補正します
+        if self.ticks is None:
+            self.ticks = low_ticks
+        else:
+            delta = (low_ticks - self.ticks) & YLOG_HEADER_TICKS_MASK
+            self.ticks += delta
+        return self.ticks
+
+    def feed(self, data):
+        self.buf += data
+        self.bytes_in += len(data)
+        out = []
+        pos = 0
+        while True:
+            start = self.buf.find(bytes([YLOG_SYNC_BYTE]), pos)
+            if start < 0:
+                pos = len(self.buf)
+                break
+            if start + 5 > len(self.buf):
+                pos = start
+                break
+
+            (header,) = struct.unpack_from("<I", self.buf, start + 1)
+            argc = (header >> YLOG_HEADER_ARGC_SHIFT) & YLOG_HEADER_ARGC_MASK
+            rec_id = header & YLOG_HEADER_ID_MASK
+            fmt = None
+            if rec_id != YLOG_ID_DROPPED:
+                fmt = self.elf.section_string(YLOG_SECTION, rec_id)
+            if (header & YLOG_HEADER_VALID) == 0 or argc > YLOG_MAX_ARG_COUNT \
+                    or (rec_id != YLOG_ID_DROPPED and fmt is None):
+                # Not a record, resync from the next byte
+                # レコードではありません、次のバイトから再同期します
+                pos = start + 1
+                continue
+
+            args = []
+            p = start + 5
+            for _ in range(argc):
+                value, p = _read_u32_leb128(self.buf, p)
+                if value is None:
+                    break
+                args.append(value)
+            if len(args) < argc:
+                if p >= len(self.buf):
+                    pos = start
+                    break
+                pos = start + 1
+                continue
+
+            ticks = self._timestamp((header >> YLOG_HEADER_TICKS_SHIFT) & YLOG_HEADER_TICKS_MASK)
+            if rec_id == YLOG_ID_DROPPED:
+                text = "<%u records dropped>\n" % args[0]
+            else:
+                text = format_record(fmt, args, self.elf)
+            self.text_bytes += len(text)
+            out.append("[%10.2f] %s" % (ticks / self.hz, text if text.endswith("\n") else text + "\n"))
+            pos = p
+
+        del self.buf[:pos]
+        return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode YOS binary logs(YLOG)")
+    parser.add_argument("elf", help="firmware ELF file with the ylog_fmt section")
+    parser.add_argument("input", nargs="?", help="captured binary log, stdin if omitted")
+    parser.add_argument("--port", help="read from a serial port instead(needs pyserial)")
+    parser.add_argument("--baud", type=int, default=921600)
+    parser.add_argument("--hz", type=int, default=100, help="YOS tick rate")
+    parser.add_argument("--stats", action="store_true",
+                        help="print binary/text byte counts at the end")
+    opts = parser.parse_args()
+
+    elf = Elf(opts.elf)
+    if YLOG_SECTION not in elf.sections:
+        sys.exit("%s has no %s section, no YLOG() is used?" % (opts.elf, YLOG_SECTION))
+
+    decoder = Decoder(elf, opts.hz)
+    if opts.port:
+        import serial
+        stream = serial.Serial(opts.port, opts.baud, timeout=0.1)
+    elif opts.input:
+        stream = open(opts.input, "rb")
+    else:
+        stream = sys.stdin.buffer
+
+    try:
+        while True:
+            data = stream.read(256)
+            if not data:
+                if opts.port:
+                    continue
+                break
+            for line in decoder.feed(data):
+                sys.stdout.write(line)
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+
+    if opts.stats and decoder.bytes_in > 0:
+        sys.stderr.write("binary %d bytes, text %d bytes, %.1fx\n"
+                         % (decoder.bytes_in, decoder.text_bytes,
+                            decoder.text_bytes / decoder.bytes_in))
+
+
+if __name__ == "__main__":
+    main()